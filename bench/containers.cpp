@@ -0,0 +1,60 @@
+#include "harness.hpp"
+
+#include <pr/fancy_allocator_adaptor.hpp>
+#include <pr/offset_ptr.hpp>
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace pr::bench {
+namespace {
+
+constexpr std::size_t element_count = 1024;
+
+template <class T>
+using offset_allocator =
+    fancy_allocator_adaptor<std::allocator<T>, offset_ptr<T>>;
+
+/**
+ * Fills a fresh container with `element_count` elements, then sums them.
+ */
+template <class Container>
+[[nodiscard]] auto fill_and_sum() -> body {
+  return [](std::size_t iterations) {
+    for (std::size_t index = 0; index < iterations; ++index) {
+      Container values;
+
+      for (std::size_t value = 0; value < element_count; ++value) {
+        values.push_back(value);
+      }
+
+      std::size_t sum = 0;
+
+      for (const auto value : values) {
+        sum += value;
+      }
+
+      do_not_optimize(sum);
+    }
+  };
+}
+
+} // namespace
+
+void register_containers(registry &benchmarks) {
+  benchmarks.add("vector/fill_sum_1024/std_allocator",
+                 fill_and_sum<std::vector<std::size_t>>());
+  benchmarks.add(
+      "vector/fill_sum_1024/offset_ptr",
+      fill_and_sum<
+          std::vector<std::size_t, offset_allocator<std::size_t>>>());
+  benchmarks.add("list/fill_sum_1024/std_allocator",
+                 fill_and_sum<std::list<std::size_t>>());
+  benchmarks.add(
+      "list/fill_sum_1024/offset_ptr",
+      fill_and_sum<std::list<std::size_t, offset_allocator<std::size_t>>>());
+}
+
+} // namespace pr::bench
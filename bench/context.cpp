@@ -0,0 +1,36 @@
+#include "harness.hpp"
+
+#include <pr/context.hpp>
+
+#include <cstddef>
+
+namespace pr::bench {
+
+void register_context(registry &benchmarks) {
+  benchmarks.add("context/push_pop", [](std::size_t iterations) {
+    for (std::size_t index = 0; index < iterations; ++index) {
+      const auto provider = make_context<std::size_t>(index);
+      do_not_optimize(get_context<std::size_t>());
+    }
+  });
+
+  benchmarks.add("context/push_pop_nested_4", [](std::size_t iterations) {
+    for (std::size_t index = 0; index < iterations; ++index) {
+      const auto first = make_context<std::size_t>(index);
+      const auto second = make_context<std::size_t>(index + 1);
+      const auto third = make_context<std::size_t>(index + 2);
+      const auto fourth = make_context<std::size_t>(index + 3);
+      do_not_optimize(get_context<std::size_t>());
+    }
+  });
+
+  benchmarks.add("context/get", [](std::size_t iterations) {
+    const auto provider = make_context<std::size_t>(iterations);
+
+    for (std::size_t index = 0; index < iterations; ++index) {
+      do_not_optimize(get_context<std::size_t>());
+    }
+  });
+}
+
+} // namespace pr::bench
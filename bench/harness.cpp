@@ -0,0 +1,211 @@
+#include "harness.hpp"
+
+#include <cctype>
+#include <charconv>
+#include <iomanip>
+#include <ios>
+#include <system_error>
+
+namespace pr::bench {
+namespace {
+
+[[nodiscard]] auto time_call(body &fn, std::size_t iterations)
+    -> std::chrono::nanoseconds {
+  const auto start = std::chrono::steady_clock::now();
+  fn(iterations);
+  clobber_memory();
+  return std::chrono::steady_clock::now() - start;
+}
+
+void write_string(std::ostream &output, std::string_view text) {
+  output << '"';
+
+  for (const auto c : text) {
+    if (c == '"' or c == '\\') {
+      output << '\\';
+    }
+
+    output << c;
+  }
+
+  output << '"';
+}
+
+class parser {
+  std::string_view input_;
+
+  void skip_whitespace() noexcept {
+    while (not input_.empty() and
+           std::isspace(static_cast<unsigned char>(input_.front())) != 0) {
+      input_.remove_prefix(1);
+    }
+  }
+
+public:
+  explicit parser(std::string_view input) noexcept : input_(input) {}
+
+  [[nodiscard]] auto consume(char expected) noexcept -> bool {
+    skip_whitespace();
+
+    if (input_.empty() or input_.front() != expected) {
+      return false;
+    }
+
+    input_.remove_prefix(1);
+    return true;
+  }
+
+  [[nodiscard]] auto peek(char expected) noexcept -> bool {
+    skip_whitespace();
+    return not input_.empty() and input_.front() == expected;
+  }
+
+  [[nodiscard]] auto string() -> std::optional<std::string> {
+    if (not consume('"')) {
+      return std::nullopt;
+    }
+
+    std::string text;
+
+    while (not input_.empty() and input_.front() != '"') {
+      if (input_.front() == '\\') {
+        input_.remove_prefix(1);
+
+        if (input_.empty()) {
+          return std::nullopt;
+        }
+      }
+
+      text.push_back(input_.front());
+      input_.remove_prefix(1);
+    }
+
+    if (not consume('"')) {
+      return std::nullopt;
+    }
+
+    return text;
+  }
+
+  [[nodiscard]] auto number() noexcept -> std::optional<double> {
+    skip_whitespace();
+    double value = 0;
+    const auto [end, error] =
+        std::from_chars(input_.data(), input_.data() + input_.size(), value);
+
+    if (error != std::errc{}) {
+      return std::nullopt;
+    }
+
+    input_.remove_prefix(static_cast<std::size_t>(end - input_.data()));
+    return value;
+  }
+};
+
+} // namespace
+
+auto registry::run(const options &opts) -> std::vector<result> {
+  std::vector<result> results;
+
+  for (auto &[name, fn] : benchmarks_) {
+    if (name.find(opts.filter) == std::string::npos) {
+      continue;
+    }
+
+    std::size_t iterations = 1;
+
+    while (time_call(fn, iterations) < opts.min_time) {
+      iterations *= 2;
+    }
+
+    std::vector<double> samples;
+
+    for (std::size_t sample = 0; sample < opts.samples; ++sample) {
+      const auto elapsed = time_call(fn, iterations);
+      samples.push_back(static_cast<double>(elapsed.count()) /
+                        static_cast<double>(iterations));
+    }
+
+    const auto median = samples.begin() + (samples.size() / 2);
+    std::ranges::nth_element(samples, median);
+    results.push_back({
+        .name = name,
+        .ns_per_op = *median,
+        .iterations = iterations,
+    });
+  }
+
+  return results;
+}
+
+void write_json(std::ostream &output, const std::vector<result> &results) {
+  const auto flags = output.flags();
+  output << std::setprecision(6) << "{\n  \"benchmarks\": [";
+
+  for (std::size_t index = 0; index < results.size(); ++index) {
+    const auto &[name, ns_per_op, iterations] = results[index];
+    output << (index == 0 ? "\n" : ",\n") << "    {\"name\": ";
+    write_string(output, name);
+    output << ", \"ns_per_op\": " << ns_per_op
+           << ", \"iterations\": " << iterations << '}';
+  }
+
+  output << "\n  ]\n}\n";
+  output.flags(flags);
+}
+
+auto read_json(std::string_view input)
+    -> std::optional<std::map<std::string, double, std::less<>>> {
+  std::map<std::string, double, std::less<>> baseline;
+  parser json(input);
+
+  if (not json.consume('{') or json.string() != "benchmarks" or
+      not json.consume(':') or not json.consume('[')) {
+    return std::nullopt;
+  }
+
+  for (bool first_entry = true; not json.consume(']'); first_entry = false) {
+    if (not first_entry and not json.consume(',')) {
+      return std::nullopt;
+    }
+
+    if (not json.consume('{')) {
+      return std::nullopt;
+    }
+
+    std::optional<std::string> name;
+    std::optional<double> ns_per_op;
+
+    for (bool first_key = true; not json.consume('}'); first_key = false) {
+      if (not first_key and not json.consume(',')) {
+        return std::nullopt;
+      }
+
+      const auto key = json.string();
+
+      if (not key or not json.consume(':')) {
+        return std::nullopt;
+      }
+
+      if (*key == "name") {
+        name = json.string();
+      } else if (*key == "ns_per_op") {
+        ns_per_op = json.number();
+      } else if (json.peek('"')) {
+        static_cast<void>(json.string());
+      } else if (not json.number()) {
+        return std::nullopt;
+      }
+    }
+
+    if (not name or not ns_per_op) {
+      return std::nullopt;
+    }
+
+    baseline.insert_or_assign(std::move(*name), *ns_per_op);
+  }
+
+  return baseline;
+}
+
+} // namespace pr::bench
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace pr::bench {
+
+/**
+ * Prevents the compiler from discarding the computation of `value`.
+ */
+template <class T>
+void do_not_optimize(const T &value) {
+  // NOLINTNEXTLINE(hicpp-no-assembler)
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Prevents the compiler from eliding or reordering stores across the call.
+ */
+inline void clobber_memory() {
+  // NOLINTNEXTLINE(hicpp-no-assembler)
+  asm volatile("" : : : "memory");
+}
+
+/**
+ * A benchmark body, which performs `iterations` operations per call. Any setup
+ * belongs in the captures of the body so that it is not timed.
+ */
+using body = std::move_only_function<void(std::size_t iterations)>;
+
+struct result {
+  std::string name;
+  double ns_per_op;
+  std::size_t iterations;
+};
+
+struct options {
+  std::chrono::nanoseconds min_time = std::chrono::milliseconds(50);
+  std::size_t samples = 5;
+  std::string_view filter;
+};
+
+class registry {
+  std::vector<std::pair<std::string, body>> benchmarks_;
+
+public:
+  void add(std::string name, body fn) {
+    benchmarks_.emplace_back(std::move(name), std::move(fn));
+  }
+
+  /**
+   * Runs each benchmark whose name contains `opts.filter`, doubling its
+   * iteration count until a call lasts at least `opts.min_time`, then reports
+   * the median time per operation of `opts.samples` calls.
+   */
+  [[nodiscard]] auto run(const options &opts) -> std::vector<result>;
+};
+
+void register_offset_ptr(registry &benchmarks);
+void register_containers(registry &benchmarks);
+void register_permutations(registry &benchmarks);
+void register_shared_view(registry &benchmarks);
+void register_context(registry &benchmarks);
+
+void write_json(std::ostream &output, const std::vector<result> &results);
+
+/**
+ * Reads the `ns_per_op` of each benchmark from JSON written by `write_json`.
+ * Returns `std::nullopt` if `input` is not in that format.
+ */
+[[nodiscard]] auto read_json(std::string_view input)
+    -> std::optional<std::map<std::string, double, std::less<>>>;
+
+} // namespace pr::bench
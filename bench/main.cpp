@@ -0,0 +1,152 @@
+#include "harness.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+constexpr std::string_view usage =
+    "usage: pr_bench [--filter <substring>] [--min-time-ms <ms>]\n"
+    "                [--samples <count>] [--output <file>]\n"
+    "                [--baseline <file>] [--threshold <fraction>]\n"
+    "\n"
+    "Writes the median nanoseconds per operation of each benchmark as JSON to\n"
+    "<file>, or to standard output. Given a baseline written by a previous\n"
+    "run, exits with a nonzero status if any benchmark is slower than its\n"
+    "baseline by more than <fraction> (0.10 by default).\n";
+
+template <class T>
+[[nodiscard]] auto parse(std::string_view text, T &value) -> bool {
+  const auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  return error == std::errc{} and end == text.data() + text.size();
+}
+
+[[nodiscard]] auto read_file(const std::string &path) -> std::string {
+  std::ifstream input(path);
+  return {std::istreambuf_iterator<char>(input),
+          std::istreambuf_iterator<char>()};
+}
+
+/**
+ * Prints each benchmark next to its baseline and returns whether any regressed
+ * by more than `threshold`.
+ */
+[[nodiscard]] auto
+compare(const std::vector<pr::bench::result> &results,
+        const std::map<std::string, double, std::less<>> &baseline,
+        double threshold) -> bool {
+  bool regressed = false;
+
+  for (const auto &[name, ns_per_op, iterations] : results) {
+    const auto found = baseline.find(name);
+
+    if (found == baseline.end()) {
+      std::fprintf(stderr, "%-48s %12.3f ns %12s\n", name.c_str(), ns_per_op,
+                   "(new)");
+      continue;
+    }
+
+    const auto change = (ns_per_op - found->second) / found->second;
+    const bool slower = change > threshold;
+    regressed = regressed or slower;
+    std::fprintf(stderr, "%-48s %12.3f ns %+11.1f%%%s\n", name.c_str(),
+                 ns_per_op, change * 100, slower ? "  REGRESSION" : "");
+  }
+
+  return regressed;
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int {
+  pr::bench::options opts;
+  std::string output_path;
+  std::string baseline_path;
+  double threshold = 0.10;
+
+  const auto args = std::span(argv, static_cast<std::size_t>(argc)).subspan(1);
+
+  for (std::size_t index = 0; index < args.size(); ++index) {
+    const std::string_view arg = args[index];
+
+    if (arg == "--help") {
+      std::cout << usage;
+      return EXIT_SUCCESS;
+    }
+
+    if (index + 1 == args.size()) {
+      std::cerr << usage;
+      return EXIT_FAILURE;
+    }
+
+    const std::string_view value = args[++index];
+    bool valid = true;
+
+    if (arg == "--filter") {
+      opts.filter = value;
+    } else if (arg == "--min-time-ms") {
+      long long milliseconds = 0;
+      valid = parse(value, milliseconds);
+      opts.min_time = std::chrono::milliseconds(milliseconds);
+    } else if (arg == "--samples") {
+      valid = parse(value, opts.samples) and opts.samples > 0;
+    } else if (arg == "--output") {
+      output_path = value;
+    } else if (arg == "--baseline") {
+      baseline_path = value;
+    } else if (arg == "--threshold") {
+      valid = parse(value, threshold);
+    } else {
+      valid = false;
+    }
+
+    if (not valid) {
+      std::cerr << usage;
+      return EXIT_FAILURE;
+    }
+  }
+
+  pr::bench::registry benchmarks;
+  pr::bench::register_offset_ptr(benchmarks);
+  pr::bench::register_containers(benchmarks);
+  pr::bench::register_permutations(benchmarks);
+  pr::bench::register_shared_view(benchmarks);
+  pr::bench::register_context(benchmarks);
+
+  const auto results = benchmarks.run(opts);
+
+  if (output_path.empty()) {
+    pr::bench::write_json(std::cout, results);
+  } else {
+    std::ofstream output(output_path);
+    pr::bench::write_json(output, results);
+
+    if (not output) {
+      std::cerr << "pr_bench: cannot write " << output_path << '\n';
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (baseline_path.empty()) {
+    return EXIT_SUCCESS;
+  }
+
+  const auto baseline = pr::bench::read_json(read_file(baseline_path));
+
+  if (not baseline) {
+    std::cerr << "pr_bench: cannot read baseline " << baseline_path << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return compare(results, *baseline, threshold) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+#include "harness.hpp"
+
+#include <pr/offset_ptr.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace pr::bench {
+namespace {
+
+constexpr std::size_t node_count = 4096;
+
+struct raw_node {
+  raw_node *next;
+  std::size_t value;
+};
+
+struct offset_node {
+  offset_ptr<offset_node> next;
+  std::size_t value;
+};
+
+/**
+ * Links `node_count` nodes into a single cycle in a shuffled order, so that
+ * each dereference depends on the previous one.
+ */
+template <class Node>
+[[nodiscard]] auto make_cycle() -> std::unique_ptr<Node[]> {
+  auto nodes = std::make_unique<Node[]>(node_count);
+  std::vector<std::size_t> order(node_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::ranges::shuffle(order, std::mt19937_64{node_count});
+
+  for (std::size_t index = 0; index < node_count; ++index) {
+    auto &current = nodes[order[index]];
+    current.next = &nodes[order[(index + 1) % node_count]];
+    current.value = index;
+  }
+
+  return nodes;
+}
+
+template <class Node>
+[[nodiscard]] auto chase() -> body {
+  return [nodes = make_cycle<Node>()](std::size_t iterations) {
+    const Node *current = &nodes[0];
+
+    for (std::size_t index = 0; index < iterations; ++index) {
+      current = std::to_address(current->next);
+    }
+
+    do_not_optimize(current);
+  };
+}
+
+template <class Pointer>
+[[nodiscard]] auto iterate() -> body {
+  return [values = std::vector<std::size_t>(node_count, 1)](
+             std::size_t iterations) mutable {
+    for (std::size_t index = 0; index < iterations; ++index) {
+      const auto first = Pointer(values.data());
+      const auto last = Pointer(values.data() + values.size());
+      std::size_t sum = 0;
+
+      for (auto it = first; it != last; ++it) {
+        sum += *it;
+      }
+
+      do_not_optimize(sum);
+    }
+  };
+}
+
+} // namespace
+
+void register_offset_ptr(registry &benchmarks) {
+  benchmarks.add("offset_ptr/deref/raw", chase<raw_node>());
+  benchmarks.add("offset_ptr/deref/offset_ptr", chase<offset_node>());
+  benchmarks.add("offset_ptr/iterate_4096/raw", iterate<std::size_t *>());
+  benchmarks.add("offset_ptr/iterate_4096/offset_ptr",
+                 iterate<offset_ptr<std::size_t>>());
+}
+
+} // namespace pr::bench
@@ -0,0 +1,53 @@
+#include "harness.hpp"
+
+#include <pr/permutations_view.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace pr::bench {
+namespace {
+
+constexpr std::size_t element_count = 8;
+
+[[nodiscard]] auto make_values() -> std::vector<int> {
+  std::vector<int> values(element_count);
+  std::iota(values.begin(), values.end(), 0);
+  return values;
+}
+
+} // namespace
+
+void register_permutations(registry &benchmarks) {
+  benchmarks.add("permutations/all_8/next_permutation",
+                 [values = make_values()](std::size_t iterations) mutable {
+                   for (std::size_t index = 0; index < iterations; ++index) {
+                     std::ranges::sort(values);
+                     int sum = 0;
+
+                     do {
+                       sum += values.front();
+                     } while (std::ranges::next_permutation(values).found);
+
+                     do_not_optimize(sum);
+                   }
+                 });
+
+  benchmarks.add("permutations/all_8/permutations_view",
+                 [values = make_values()](std::size_t iterations) mutable {
+                   for (std::size_t index = 0; index < iterations; ++index) {
+                     int sum = 0;
+
+                     for (const auto &permutation :
+                          values | views::permutations) {
+                       sum += permutation.front();
+                     }
+
+                     do_not_optimize(sum);
+                   }
+                 });
+}
+
+} // namespace pr::bench
@@ -0,0 +1,36 @@
+#include "harness.hpp"
+
+#include <pr/shared_view.hpp>
+
+#include <cstddef>
+#include <ranges>
+#include <vector>
+
+namespace pr::bench {
+namespace {
+
+/**
+ * Copies `view` once per operation, which for `pr::ranges::shared_view` costs
+ * a reference count increment and decrement.
+ */
+template <class View>
+[[nodiscard]] auto copy(View view) -> body {
+  return [view = std::move(view)](std::size_t iterations) {
+    for (std::size_t index = 0; index < iterations; ++index) {
+      auto copied = view;
+      do_not_optimize(copied);
+    }
+  };
+}
+
+} // namespace
+
+void register_shared_view(registry &benchmarks) {
+  static std::vector<int> values(1024, 1);
+
+  benchmarks.add("shared_view/copy/ref_view", copy(std::views::all(values)));
+  benchmarks.add("shared_view/copy/shared_view",
+                 copy(std::vector<int>(values) | views::shared));
+}
+
+} // namespace pr::bench
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <pr/context.hpp>
+#include <pr/fancy_allocator_adaptor.hpp>
+#include <pr/offset_ptr.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+
+namespace pr {
+
+/**
+ * A monotonic bump allocator over a caller-provided region, such as a
+ * `pr::mapping`. Only the most recent allocation can be expanded in place or
+ * given back; other deallocations are no-ops. Its members are relative, so an
+ * arena placed inside its own region remains valid when the region is mapped
+ * at a different address. Not thread-safe.
+ */
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+class arena {
+public:
+  static constexpr std::size_t granularity = alignof(std::max_align_t);
+
+private:
+  offset_ptr<std::byte> begin_;
+  std::size_t capacity_ = 0;
+  std::size_t used_ = 0;
+
+  [[nodiscard]] static constexpr auto round_up(std::size_t bytes) noexcept
+      -> std::size_t {
+    return (bytes + granularity - 1) / granularity * granularity;
+  }
+
+  [[nodiscard]] auto top() const noexcept -> std::byte * {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return begin_.get() + used_;
+  }
+
+public:
+  arena() = default;
+
+  explicit arena(std::span<std::byte> memory) noexcept
+      : begin_(memory.data()), capacity_(memory.size()) {}
+
+  arena(const arena &) = delete;
+
+  auto operator=(const arena &) -> arena & = delete;
+
+  ~arena() = default;
+
+  [[nodiscard]] auto capacity() const noexcept -> std::size_t {
+    return capacity_;
+  }
+
+  [[nodiscard]] auto used() const noexcept -> std::size_t { return used_; }
+
+  /**
+   * Returns the bytes handed out so far, starting at the beginning of the
+   * region.
+   */
+  [[nodiscard]] auto data() const noexcept -> std::span<std::byte> {
+    return {begin_.get(), used_};
+  }
+
+  [[nodiscard]] auto contains(const void *p) const noexcept -> bool {
+    const auto *byte = static_cast<const std::byte *>(p);
+    return std::less_equal<>{}(begin_.get(), byte) and
+           std::less<>{}(byte, top());
+  }
+
+  /**
+   * Returns storage for at least `bytes` bytes aligned to `align`, rounding the
+   * size up to a multiple of `granularity` and writing it to `bytes`, or
+   * `nullptr` if the region is exhausted.
+   */
+  [[nodiscard]] auto try_allocate_at_least(std::size_t &bytes,
+                                           std::size_t align) noexcept
+      -> std::byte * {
+    void *p = top();
+    auto space = capacity_ - used_;
+    const auto rounded = round_up(bytes);
+
+    if (std::align(align, rounded, p, space) == nullptr) {
+      return nullptr;
+    }
+
+    bytes = rounded;
+    auto *result = static_cast<std::byte *>(p);
+    used_ = static_cast<std::size_t>(result - begin_.get()) + rounded;
+    return result;
+  }
+
+  /**
+   * If `p` is the most recent allocation of `old_bytes` bytes, grows or
+   * shrinks it to `new_bytes` bytes if there is room and returns `true`. Sizes
+   * are rounded up to a multiple of `granularity`.
+   */
+  [[nodiscard]] auto try_expand(std::byte *p, std::size_t old_bytes,
+                                std::size_t new_bytes) noexcept -> bool {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    if (p == nullptr or p + round_up(old_bytes) != top()) {
+      return false;
+    }
+
+    const auto offset = static_cast<std::size_t>(p - begin_.get());
+
+    if (new_bytes > capacity_ - offset or
+        round_up(new_bytes) > capacity_ - offset) {
+      return false;
+    }
+
+    used_ = offset + round_up(new_bytes);
+    return true;
+  }
+
+  /**
+   * Gives back `p` if it is the most recent allocation of `bytes` bytes,
+   * rounded up to a multiple of `granularity`.
+   */
+  void deallocate(std::byte *p, std::size_t bytes) noexcept {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    if (p != nullptr and p + round_up(bytes) == top()) {
+      used_ = static_cast<std::size_t>(p - begin_.get());
+    }
+  }
+};
+
+/**
+ * An allocator drawing from a `pr::arena`. When default-constructed, it draws
+ * from `pr::get_context<pr::arena>()`. It refers to its arena with an
+ * `offset_ptr`, so it may be stored inside the arena's region alongside the
+ * containers using it. Allocation throws `std::bad_alloc` when the arena is
+ * exhausted.
+ */
+template <class T>
+class arena_allocator {
+  template <class U>
+  friend class arena_allocator;
+
+  offset_ptr<arena> arena_{get_context<arena>()};
+
+  static constexpr std::size_t max_n =
+      std::numeric_limits<std::size_t>::max() / sizeof(T);
+
+  [[nodiscard]] static constexpr auto bytes_for(std::size_t n) noexcept
+      -> std::size_t {
+    return n * sizeof(T);
+  }
+
+public:
+  using value_type = T;
+
+  arena_allocator() = default;
+
+  explicit arena_allocator(arena &source) noexcept
+      : arena_(std::addressof(source)) {}
+
+  template <class U>
+  // NOLINTNEXTLINE(google-explicit-constructor,hicpp-explicit-conversions)
+  arena_allocator(const arena_allocator<U> &other) noexcept
+      : arena_(other.arena_) {}
+
+  [[nodiscard]] auto resource() const noexcept -> arena * {
+    return arena_.get();
+  }
+
+  [[nodiscard]] static constexpr auto max_size() noexcept -> std::size_t {
+    return max_n;
+  }
+
+  [[nodiscard]] auto allocate_at_least(std::size_t n)
+      -> allocation_result<T *, std::size_t> {
+    if (n > max_n or not arena_) {
+      throw std::bad_alloc();
+    }
+
+    auto bytes = bytes_for(n);
+    auto *p = arena_->try_allocate_at_least(bytes, alignof(T));
+
+    if (p == nullptr) {
+      throw std::bad_alloc();
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return {reinterpret_cast<T *>(p), bytes / sizeof(T)};
+  }
+
+  [[nodiscard]] auto allocate(std::size_t n) -> T * {
+    return allocate_at_least(n).ptr;
+  }
+
+  void deallocate(T *p, std::size_t n) noexcept {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    arena_->deallocate(reinterpret_cast<std::byte *>(p), bytes_for(n));
+  }
+
+  [[nodiscard]] auto try_expand(T *p, std::size_t old_n,
+                                std::size_t new_n) noexcept -> bool {
+    return new_n <= max_n and
+           arena_->try_expand(
+               // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+               reinterpret_cast<std::byte *>(p), bytes_for(old_n),
+               bytes_for(new_n));
+  }
+
+  template <class U>
+  [[nodiscard]] auto operator==(const arena_allocator<U> &other) const noexcept
+      -> bool {
+    return arena_ == other.arena_;
+  }
+};
+
+} // namespace pr
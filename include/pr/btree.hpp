@@ -0,0 +1,701 @@
+#pragma once
+
+#include <pr/arena.hpp>
+#include <pr/offset_ptr.hpp>
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pr {
+
+/**
+ * An ordered map from unique arithmetic keys to trivially copyable values,
+ * stored as a B+tree of nodes spanning `NodeLines` cache lines each and linked
+ * with `pr::offset_ptr`. Leaves are chained for sequential scans. The tree and
+ * its nodes contain no absolute addresses, so a tree allocated together with
+ * its nodes inside one region, e.g. with the default `pr::arena_allocator`,
+ * remains valid when the region is mapped at a different address.
+ *
+ * Links are represented by `Rep`. A signed 32-bit `Rep` halves the size of
+ * every link, and so raises the fanout of inner nodes, at the cost of
+ * requiring every node to lie within 2 GiB of the nodes linking to it.
+ *
+ * Erasure is lazy: entries are removed from their leaf, but nodes are never
+ * merged or freed until the tree is cleared.
+ */
+template <class Key, class Value, std::size_t NodeLines = 4,
+          std::integral Rep = std::uintptr_t,
+          class Allocator = arena_allocator<std::byte>>
+  requires std::is_arithmetic_v<Key> and std::is_trivially_copyable_v<Value> and
+           (std::signed_integral<Rep> or sizeof(Rep) == sizeof(std::uintptr_t))
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+class btree {
+public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using size_type = std::size_t;
+  using allocator_type = Allocator;
+
+  static constexpr std::size_t cache_line = 64;
+  static constexpr std::size_t node_bytes = NodeLines * cache_line;
+
+private:
+  template <class T>
+  using link_ = offset_ptr<T, std::ptrdiff_t, Rep, alignof(Rep), 1>;
+
+  /**
+   * Pads the unused keys of every node so that a search can compare the full
+   * width of a node without a data-dependent trip count.
+   */
+  static constexpr Key sentinel = std::numeric_limits<Key>::has_infinity
+                                      ? std::numeric_limits<Key>::infinity()
+                                      : std::numeric_limits<Key>::max();
+
+  struct node_ {
+    std::uint32_t count = 0;
+  };
+
+  static constexpr std::size_t leaf_header =
+      std::max(sizeof(std::uint32_t), alignof(link_<node_>)) +
+      sizeof(link_<node_>);
+
+  static constexpr std::size_t inner_header =
+      std::max(sizeof(std::uint32_t), alignof(Key));
+
+public:
+  static constexpr std::size_t leaf_capacity =
+      (node_bytes - leaf_header - alignof(Key) - alignof(Value)) /
+      (sizeof(Key) + sizeof(Value));
+
+  static constexpr std::size_t inner_capacity =
+      (node_bytes - inner_header - sizeof(link_<node_>) -
+       alignof(link_<node_>)) /
+      (sizeof(Key) + sizeof(link_<node_>));
+
+private:
+  /**
+   * Counts the elements of `keys` satisfying `predicate`, at most `count`,
+   * over the full width of `keys` and without branches, which compilers
+   * vectorize; the sentinel padding never satisfies a predicate below it.
+   */
+  template <std::size_t Count, class Predicate>
+  [[nodiscard]] static auto count_if(const std::array<Key, Count> &keys,
+                                     std::uint32_t count,
+                                     Predicate predicate) noexcept
+      -> std::uint32_t {
+    std::uint32_t result = 0;
+
+    for (const auto key : keys) {
+      result += static_cast<std::uint32_t>(predicate(key));
+    }
+
+    return std::min(result, count);
+  }
+
+  struct alignas(cache_line) leaf_ : node_ {
+    link_<leaf_> next;
+    std::array<Key, leaf_capacity> keys;
+    std::array<Value, leaf_capacity> values;
+
+    leaf_() noexcept { keys.fill(sentinel); }
+
+    [[nodiscard]] auto lower_bound(Key key) const noexcept -> std::uint32_t {
+      return count_if(keys, this->count,
+                      [key](Key other) { return other < key; });
+    }
+
+    void insert(std::uint32_t pos, Key key, const Value &value) noexcept {
+      const auto end = this->count;
+      std::copy_backward(keys.begin() + pos, keys.begin() + end,
+                         keys.begin() + end + 1);
+      std::copy_backward(values.begin() + pos, values.begin() + end,
+                         values.begin() + end + 1);
+      keys[pos] = key;
+      values[pos] = value;
+      ++this->count;
+    }
+
+    void erase(std::uint32_t pos) noexcept {
+      const auto end = this->count;
+      std::copy(keys.begin() + pos + 1, keys.begin() + end, keys.begin() + pos);
+      std::copy(values.begin() + pos + 1, values.begin() + end,
+                values.begin() + pos);
+      keys[end - 1] = sentinel;
+      --this->count;
+    }
+  };
+
+  struct alignas(cache_line) inner_ : node_ {
+    std::array<Key, inner_capacity> keys;
+    std::array<link_<node_>, inner_capacity + 1> children;
+
+    inner_() noexcept { keys.fill(sentinel); }
+
+    /**
+     * Returns the index of the child whose subtree may contain `key`; a
+     * separator is the smallest key of the subtree to its right.
+     */
+    [[nodiscard]] auto child_index(Key key) const noexcept -> std::uint32_t {
+      return count_if(keys, this->count,
+                      [key](Key other) { return other <= key; });
+    }
+
+    [[nodiscard]] auto child(std::uint32_t index) const noexcept -> node_ * {
+      return children[index].get();
+    }
+  };
+
+  static_assert(sizeof(leaf_) <= node_bytes and sizeof(inner_) <= node_bytes);
+  static_assert(leaf_capacity >= 2 and inner_capacity >= 2,
+                "pr::btree: NodeLines is too small for Key and Value");
+
+  // every inner node has at least two children, so no tree is deeper
+  static constexpr std::size_t max_height =
+      std::numeric_limits<size_type>::digits;
+
+  using leaf_allocator =
+      std::allocator_traits<Allocator>::template rebind_alloc<leaf_>;
+  using inner_allocator =
+      std::allocator_traits<Allocator>::template rebind_alloc<inner_>;
+
+  link_<node_> root_;
+  link_<leaf_> first_;
+  size_type size_ = 0;
+  std::uint32_t height_ = 0;
+  [[no_unique_address]] Allocator alloc_;
+
+  template <class Node, class NodeAllocator>
+  [[nodiscard]] auto make_node() -> Node * {
+    using traits = std::allocator_traits<NodeAllocator>;
+    NodeAllocator alloc(alloc_);
+    return std::construct_at(std::to_address(traits::allocate(alloc, 1)));
+  }
+
+  template <class Node, class NodeAllocator>
+  void free_node(Node *node) noexcept {
+    using traits = std::allocator_traits<NodeAllocator>;
+    NodeAllocator alloc(alloc_);
+    std::destroy_at(node);
+    traits::deallocate(
+        alloc, std::pointer_traits<typename traits::pointer>::pointer_to(*node),
+        1);
+  }
+
+  [[nodiscard]] auto make_leaf() -> leaf_ * {
+    return make_node<leaf_, leaf_allocator>();
+  }
+
+  [[nodiscard]] auto make_inner() -> inner_ * {
+    return make_node<inner_, inner_allocator>();
+  }
+
+  void free_subtree(node_ *node, std::uint32_t height) noexcept {
+    if (height == 0) {
+      free_node<leaf_, leaf_allocator>(static_cast<leaf_ *>(node));
+      return;
+    }
+
+    auto *inner = static_cast<inner_ *>(node);
+
+    for (std::uint32_t index = 0; index <= inner->count; ++index) {
+      free_subtree(inner->child(index), height - 1);
+    }
+
+    free_node<inner_, inner_allocator>(inner);
+  }
+
+  [[nodiscard]] auto find_leaf(Key key) const noexcept -> leaf_ * {
+    auto *node = root_.get();
+
+    for (auto level = height_; level > 0; --level) {
+      const auto *inner = static_cast<const inner_ *>(node);
+      node = inner->child(inner->child_index(key));
+    }
+
+    return static_cast<leaf_ *>(node);
+  }
+
+  using path_ = std::array<std::pair<inner_ *, std::uint32_t>, max_height>;
+
+  /**
+   * Owns inner nodes allocated ahead of a split, so that a split either
+   * allocates every node it needs before modifying the tree or fails without
+   * modifying it. Nodes not taken are freed on destruction.
+   */
+  // NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+  class spare_inners_ {
+    btree *tree_;
+    std::array<inner_ *, max_height + 1> nodes_{};
+    std::size_t count_ = 0;
+
+  public:
+    explicit spare_inners_(btree &tree) noexcept : tree_(&tree) {}
+
+    spare_inners_(const spare_inners_ &) = delete;
+
+    ~spare_inners_() {
+      while (count_ > 0) {
+        tree_->free_node<inner_, inner_allocator>(take());
+      }
+    }
+
+    /**
+     * Allocates one node for each full ancestor in `path[0, depth)` that a
+     * split propagates through, and one for a new root if they all are.
+     */
+    void reserve(const path_ &path, std::size_t depth) {
+      std::size_t count = 0;
+
+      while (count < depth and
+             path[depth - count - 1].first->count == inner_capacity) {
+        ++count;
+      }
+
+      count += static_cast<std::size_t>(count == depth);
+
+      while (count_ < count) {
+        nodes_[count_] = tree_->make_inner();
+        ++count_;
+      }
+    }
+
+    [[nodiscard]] auto take() noexcept -> inner_ * { return nodes_[--count_]; }
+  };
+
+  /**
+   * Inserts `separator` and its right subtree `right` into the inner node at
+   * `path[depth - 1]`, splitting ancestors as needed with nodes reserved in
+   * `spares`.
+   */
+  void insert_into_parent(const path_ &path, std::size_t depth, Key separator,
+                          node_ *right, spare_inners_ &spares) noexcept {
+    while (depth > 0) {
+      auto [parent, index] = path[--depth];
+      const auto count = parent->count;
+
+      if (count < inner_capacity) {
+        std::copy_backward(parent->keys.begin() + index,
+                           parent->keys.begin() + count,
+                           parent->keys.begin() + count + 1);
+        std::copy_backward(parent->children.begin() + index + 1,
+                           parent->children.begin() + count + 1,
+                           parent->children.begin() + count + 2);
+        parent->keys[index] = separator;
+        parent->children[index + 1] = right;
+        ++parent->count;
+        return;
+      }
+
+      std::array<Key, inner_capacity + 1> keys{};
+      std::array<node_ *, inner_capacity + 2> children{};
+
+      for (std::uint32_t from = 0, to = 0; from < count; ++from, ++to) {
+        to += static_cast<std::uint32_t>(from == index);
+        keys[to] = parent->keys[from];
+      }
+
+      for (std::uint32_t from = 0, to = 0; from <= count; ++from, ++to) {
+        to += static_cast<std::uint32_t>(from == index + 1);
+        children[to] = parent->child(from);
+      }
+
+      keys[index] = separator;
+      children[index + 1] = right;
+
+      constexpr auto mid = static_cast<std::uint32_t>((inner_capacity + 1) / 2);
+      auto *sibling = spares.take();
+
+      parent->keys.fill(sentinel);
+      std::copy(keys.begin(), keys.begin() + mid, parent->keys.begin());
+      std::copy(keys.begin() + mid + 1, keys.end(), sibling->keys.begin());
+
+      for (std::uint32_t i = 0; i <= mid; ++i) {
+        parent->children[i] = children[i];
+      }
+
+      for (std::uint32_t i = mid + 1; i < children.size(); ++i) {
+        sibling->children[i - mid - 1] = children[i];
+      }
+
+      parent->count = mid;
+      sibling->count = static_cast<std::uint32_t>(inner_capacity) - mid;
+      separator = keys[mid];
+      right = sibling;
+    }
+
+    auto *root = spares.take();
+    root->keys[0] = separator;
+    root->children[0] = root_;
+    root->children[1] = right;
+    root->count = 1;
+    root_ = root;
+    ++height_;
+  }
+
+  template <bool Const>
+  class iterator_ {
+    friend btree;
+    friend iterator_<not Const>;
+
+    using leaf_pointer = std::conditional_t<Const, const leaf_ *, leaf_ *>;
+    using value_reference = std::conditional_t<Const, const Value &, Value &>;
+
+    leaf_pointer current_ = nullptr;
+    std::uint32_t pos_ = 0;
+
+    iterator_(leaf_pointer current, std::uint32_t pos) noexcept
+        : current_(current), pos_(pos) {
+      skip_exhausted();
+    }
+
+    void skip_exhausted() noexcept {
+      while (current_ != nullptr and pos_ == current_->count) {
+        current_ = current_->next.get();
+        pos_ = 0;
+      }
+    }
+
+  public:
+    using value_type = std::pair<Key, Value>;
+    using reference = std::pair<const Key &, value_reference>;
+    using difference_type = std::ptrdiff_t;
+    using iterator_concept = std::forward_iterator_tag;
+
+    iterator_() = default;
+
+    template <bool OtherConst>
+      requires(Const and not OtherConst)
+    // NOLINTNEXTLINE(google-explicit-constructor,hicpp-explicit-conversions)
+    iterator_(const iterator_<OtherConst> &other) noexcept
+        : current_(other.current_), pos_(other.pos_) {}
+
+    [[nodiscard]] auto key() const noexcept -> const Key & {
+      return current_->keys[pos_];
+    }
+
+    [[nodiscard]] auto value() const noexcept -> value_reference {
+      return current_->values[pos_];
+    }
+
+    [[nodiscard]] auto operator*() const noexcept -> reference {
+      return {key(), value()};
+    }
+
+    auto operator++() noexcept -> iterator_ & {
+      ++pos_;
+      skip_exhausted();
+      return *this;
+    }
+
+    auto operator++(int) noexcept -> iterator_ {
+      auto other = *this;
+      ++*this;
+      return other;
+    }
+
+    [[nodiscard]] auto operator==(const iterator_ &other) const noexcept
+        -> bool = default;
+  };
+
+public:
+  using iterator = iterator_<false>;
+  using const_iterator = iterator_<true>;
+
+  btree()
+    requires std::default_initializable<Allocator>
+  = default;
+
+  explicit btree(const Allocator &alloc) noexcept : alloc_(alloc) {}
+
+  btree(const btree &) = delete;
+
+  btree(btree &&other) noexcept
+      : root_(std::exchange(other.root_, nullptr)),
+        first_(std::exchange(other.first_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        height_(std::exchange(other.height_, 0)),
+        alloc_(std::move(other.alloc_)) {}
+
+  auto operator=(btree &&other) noexcept -> btree & {
+    std::destroy_at(this);
+    std::construct_at(this, std::move(other));
+    return *this;
+  }
+
+  ~btree() { clear(); }
+
+  [[nodiscard]] auto get_allocator() const noexcept -> allocator_type {
+    return alloc_;
+  }
+
+  [[nodiscard]] auto size() const noexcept -> size_type { return size_; }
+
+  [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+
+  /**
+   * Returns the number of inner levels above the leaves.
+   */
+  [[nodiscard]] auto height() const noexcept -> std::uint32_t {
+    return height_;
+  }
+
+  [[nodiscard]] auto begin() noexcept -> iterator {
+    return {first_.get(), 0};
+  }
+
+  [[nodiscard]] auto begin() const noexcept -> const_iterator {
+    return {first_.get(), 0};
+  }
+
+  [[nodiscard]] auto end() noexcept -> iterator { return {}; }
+
+  [[nodiscard]] auto end() const noexcept -> const_iterator { return {}; }
+
+  /**
+   * Returns an iterator to the first entry whose key is not less than `key`.
+   */
+  [[nodiscard]] auto lower_bound(Key key) noexcept -> iterator {
+    auto *leaf = root_ ? find_leaf(key) : nullptr;
+    return {leaf, leaf ? leaf->lower_bound(key) : 0};
+  }
+
+  [[nodiscard]] auto lower_bound(Key key) const noexcept -> const_iterator {
+    const auto *leaf = root_ ? find_leaf(key) : nullptr;
+    return {leaf, leaf ? leaf->lower_bound(key) : 0};
+  }
+
+  [[nodiscard]] auto find(Key key) noexcept -> iterator {
+    const auto it = lower_bound(key);
+    return it != end() and it.key() == key ? it : end();
+  }
+
+  [[nodiscard]] auto find(Key key) const noexcept -> const_iterator {
+    const auto it = lower_bound(key);
+    return it != end() and it.key() == key ? it : end();
+  }
+
+  [[nodiscard]] auto contains(Key key) const noexcept -> bool {
+    return find(key) != end();
+  }
+
+  /**
+   * Inserts `value` under `key` unless `key` is already present. Returns an
+   * iterator to the entry for `key` and whether it was inserted.
+   */
+  auto insert(Key key, const Value &value) -> std::pair<iterator, bool> {
+    if (not root_) {
+      auto *leaf = make_leaf();
+      root_ = leaf;
+      first_ = leaf;
+    }
+
+    path_ path{};
+    std::size_t depth = 0;
+    auto *node = root_.get();
+
+    for (auto level = height_; level > 0; --level) {
+      auto *inner = static_cast<inner_ *>(node);
+      const auto index = inner->child_index(key);
+      path[depth++] = {inner, index};
+      node = inner->child(index);
+    }
+
+    auto *leaf = static_cast<leaf_ *>(node);
+    const auto pos = leaf->lower_bound(key);
+
+    if (pos < leaf->count and leaf->keys[pos] == key) {
+      return {iterator(leaf, pos), false};
+    }
+
+    if (leaf->count < leaf_capacity) {
+      leaf->insert(pos, key, value);
+      ++size_;
+      return {iterator(leaf, pos), true};
+    }
+
+    // nothing below throws once every node of the split is allocated
+    spare_inners_ spares(*this);
+    spares.reserve(path, depth);
+    auto *sibling = make_leaf();
+
+    // appending to the last leaf leaves it full, so that ascending inserts
+    // fill every leaf
+    constexpr auto half = static_cast<std::uint32_t>(leaf_capacity / 2);
+    const auto mid = pos == leaf_capacity and not leaf->next
+                         ? static_cast<std::uint32_t>(leaf_capacity)
+                         : half;
+
+    std::copy(leaf->keys.begin() + mid, leaf->keys.end(),
+              sibling->keys.begin());
+    std::copy(leaf->values.begin() + mid, leaf->values.end(),
+              sibling->values.begin());
+    std::fill(leaf->keys.begin() + mid, leaf->keys.end(), sentinel);
+    sibling->count = static_cast<std::uint32_t>(leaf_capacity) - mid;
+    leaf->count = mid;
+    sibling->next = leaf->next;
+    leaf->next = sibling;
+
+    auto inserted = iterator(leaf, pos);
+
+    if (pos < mid) {
+      leaf->insert(pos, key, value);
+    } else {
+      sibling->insert(pos - mid, key, value);
+      inserted = iterator(sibling, pos - mid);
+    }
+
+    insert_into_parent(path, depth, sibling->keys[0], sibling, spares);
+    ++size_;
+    return {inserted, true};
+  }
+
+  /**
+   * Removes the entry for `key`, if any, without rebalancing the tree.
+   */
+  auto erase(Key key) noexcept -> size_type {
+    if (not root_) {
+      return 0;
+    }
+
+    auto *leaf = find_leaf(key);
+    const auto pos = leaf->lower_bound(key);
+
+    if (pos == leaf->count or leaf->keys[pos] != key) {
+      return 0;
+    }
+
+    leaf->erase(pos);
+    --size_;
+    return 1;
+  }
+
+  void clear() noexcept {
+    if (root_) {
+      free_subtree(root_.get(), height_);
+    }
+
+    root_ = nullptr;
+    first_ = nullptr;
+    size_ = 0;
+    height_ = 0;
+  }
+
+  /**
+   * Builds the tree bottom-up from `entries`, pairs of a key and a value in
+   * strictly ascending order of key, filling every node. If the tree already
+   * has nodes, each entry is inserted instead.
+   */
+  template <std::ranges::input_range R>
+  void bulk_load(R &&entries) {
+    if (root_) {
+      for (const auto &[key, value] : entries) {
+        insert(key, value);
+      }
+
+      return;
+    }
+
+    // each node of the level being built and the smallest key beneath it
+    std::vector<std::pair<node_ *, Key>> level;
+    std::vector<inner_ *> inners;
+    leaf_ *leaf = nullptr;
+    size_type size = 0;
+
+    // the tree is published only once every node is allocated, and nodes are
+    // freed in reverse so that an arena reclaims them
+    try {
+      for (const auto &[key, value] : entries) {
+        if (leaf == nullptr or leaf->count == leaf_capacity) {
+          level.emplace_back(nullptr, key);
+          auto *next = make_leaf();
+          level.back().first = next;
+
+          if (leaf != nullptr) {
+            leaf->next = next;
+          }
+
+          leaf = next;
+        }
+
+        leaf->keys[leaf->count] = key;
+        leaf->values[leaf->count] = value;
+        ++leaf->count;
+        ++size;
+      }
+
+      std::size_t count = 0;
+
+      for (auto width = level.size(); width > 1; count += width) {
+        width = (width + inner_capacity) / (inner_capacity + 1);
+      }
+
+      inners.reserve(count);
+
+      while (inners.size() < count) {
+        inners.push_back(make_inner());
+      }
+    } catch (...) {
+      for (auto *inner : inners | std::views::reverse) {
+        free_node<inner_, inner_allocator>(inner);
+      }
+
+      for (const auto &entry : level | std::views::reverse) {
+        if (entry.first != nullptr) {
+          free_node<leaf_, leaf_allocator>(static_cast<leaf_ *>(entry.first));
+        }
+      }
+
+      throw;
+    }
+
+    if (level.empty()) {
+      return;
+    }
+
+    auto *head = static_cast<leaf_ *>(level.front().first);
+    auto next = inners.begin();
+    std::uint32_t height = 0;
+
+    // each level is built in place over the one below, which it never
+    // overtakes
+    while (level.size() > 1) {
+      std::size_t width = 0;
+
+      for (std::size_t first = 0; first < level.size();
+           first += inner_capacity + 1) {
+        const auto last = std::min(level.size(), first + inner_capacity + 1);
+        auto *inner = *next++;
+
+        inner->children[0] = level[first].first;
+
+        for (auto index = first + 1; index < last; ++index) {
+          inner->keys[inner->count] = level[index].second;
+          inner->children[++inner->count] = level[index].first;
+        }
+
+        level[width++] = {inner, level[first].second};
+      }
+
+      level.erase(level.begin() + static_cast<std::ptrdiff_t>(width),
+                  level.end());
+      ++height;
+    }
+
+    root_ = level.front().first;
+    first_ = head;
+    size_ = size;
+    height_ = height;
+  }
+};
+
+} // namespace pr
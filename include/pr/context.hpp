@@ -1,5 +1,6 @@
 #pragma once
 
+#include <tuple>
 #include <utility>
 
 namespace pr {
@@ -44,6 +45,71 @@ public:
 template <class T>
 concept gettable_ = storable_<std::remove_const_t<T>>;
 
+template <class T, class... Ts>
+inline constexpr std::size_t count_ =
+    (std::size_t{0} + ... + std::is_same_v<T, Ts>);
+
+template <class... Ts>
+concept distinct_ = ((count_<Ts, Ts...> == 1) and ...);
+
+} // namespace detail
+
+/**
+ * A snapshot of the thread-local context pointers `context_<Ts>...`, suitable
+ * for carrying contexts installed by `pr::make_context` across a thread or
+ * coroutine hop. A snapshot only stores pointers, so the providers that
+ * installed them must outlive every use of the snapshot.
+ */
+template <detail::storable_... Ts>
+  requires detail::distinct_<Ts...>
+class context_snapshot {
+  std::tuple<Ts *...> contexts_;
+
+public:
+  constexpr context_snapshot() noexcept = default;
+
+  constexpr explicit context_snapshot(Ts *...contexts) noexcept
+    requires(sizeof...(Ts) > 0)
+      : contexts_(contexts...) {}
+
+  /**
+   * Exchanges each stored pointer with `context_<T>` of the calling thread.
+   * Calling this twice on the same thread restores both the snapshot and the
+   * thread to their original values.
+   */
+  void exchange() noexcept {
+    (std::swap(std::get<Ts *>(contexts_), detail::context_<Ts>), ...);
+  }
+
+  template <detail::gettable_ T>
+    requires(std::same_as<std::remove_const_t<T>, Ts> or ...)
+  [[nodiscard]] constexpr auto get() const noexcept -> T * {
+    return std::get<std::remove_const_t<T> *>(contexts_);
+  }
+};
+
+namespace detail {
+
+template <storable_... Ts>
+  requires distinct_<Ts...>
+class restorer_ {
+  context_snapshot<Ts...> contexts_;
+
+public:
+  explicit restorer_(const context_snapshot<Ts...> &contexts) noexcept
+      : contexts_(contexts) {
+    contexts_.exchange();
+  }
+
+  restorer_(const restorer_ &) = delete;
+  restorer_(restorer_ &&) = delete;
+
+  auto operator=(const restorer_ &) -> restorer_ & = delete;
+  auto operator=(restorer_ &&) -> restorer_ & = delete;
+
+  ~restorer_() noexcept { contexts_.exchange(); }
+};
+
 } // namespace detail
 
 /**
@@ -85,4 +151,30 @@ template <detail::gettable_ T>
   return detail::context_<value_type>;
 }
 
+/**
+ * Returns a `pr::context_snapshot<Ts...>` holding the current values of
+ * `context_<Ts>...` on the calling thread. Each `T` must be a cv-unqualified
+ * non-reference type, and no type may appear more than once.
+ */
+template <detail::storable_... Ts>
+  requires detail::distinct_<Ts...>
+[[nodiscard]] auto capture_context() noexcept -> context_snapshot<Ts...> {
+  return context_snapshot<Ts...>(detail::context_<Ts>...);
+}
+
+/**
+ * Constructs and returns an object whose constructor installs the pointers
+ * held by `contexts` into `context_<Ts>...` of the calling thread, and whose
+ * destructor reinstates the values they replaced. The copy and move
+ * constructors of the return type are deleted. The cost of each direction is
+ * two pointer stores per type in `Ts`.
+ */
+template <detail::storable_... Ts>
+  requires detail::distinct_<Ts...>
+[[nodiscard]] auto
+restore_context(const context_snapshot<Ts...> &contexts) noexcept
+    -> detail::restorer_<Ts...> {
+  return detail::restorer_<Ts...>(contexts);
+}
+
 } // namespace pr
@@ -0,0 +1,424 @@
+#pragma once
+
+#include <pr/offset_ptr.hpp>
+
+#include <signal.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <utility>
+
+namespace pr {
+
+/**
+ * An intrusive hook for objects retired to a `pr::epoch_domain`. It must be
+ * allocated in the same segment as the domain.
+ */
+struct epoch_node {
+  offset_ptr<epoch_node> next;
+  std::uint64_t epoch = 0;
+};
+
+/**
+ * Describes a participant that has kept the global epoch from advancing for
+ * `attempts` consecutive attempts.
+ */
+struct epoch_stall {
+  std::size_t slot;
+  pid_t owner;
+  std::uint64_t epoch;
+  std::uint32_t attempts;
+};
+
+/**
+ * What a stall handler tells `pr::epoch_participant::collect` to do with a
+ * stalled participant. `evict` frees the participant's slot and hands its
+ * retired nodes to the collector without synchronizing with it, so it may only
+ * be returned for a participant whose process has exited. A live participant
+ * would keep using a slot that may since have been registered again, which is
+ * undefined behavior. To get past a live participant, return `wait` until it
+ * leaves its critical section.
+ */
+enum class epoch_stall_action : std::uint8_t {
+  wait,
+  evict,
+};
+
+/**
+ * The default stall handler, which evicts a participant only if the process
+ * that registered it no longer exists.
+ */
+[[nodiscard]] inline auto evict_if_dead(const epoch_stall &stall) noexcept
+    -> epoch_stall_action {
+  return kill(stall.owner, 0) == -1 and errno == ESRCH
+             ? epoch_stall_action::evict
+             : epoch_stall_action::wait;
+}
+
+template <std::size_t MaxParticipants>
+class epoch_participant;
+
+/**
+ * An epoch-based reclamation domain for lock-free structures shared between
+ * threads and processes. It is constructed once inside a shared segment, such
+ * as a `pr::mapping` of a `pr::shared_memory`, and holds no absolute
+ * addresses: each participant announces its epoch in a slot of the segment
+ * and keeps the nodes it retires in an `offset_ptr` list in that slot.
+ *
+ * Readers enter a critical section by announcing the global epoch. A node
+ * retired at epoch `e` is reclaimed once the global epoch reaches `e + 2`,
+ * which requires every participant inside a critical section to have
+ * announced `e + 1`. A participant that blocks advancement for
+ * `stall_threshold` consecutive attempts is reported to a stall handler,
+ * which may evict it and adopt its retired nodes if its process has exited.
+ */
+template <std::size_t MaxParticipants = 64>
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+class epoch_domain {
+  friend epoch_participant<MaxParticipants>;
+
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free and
+                    std::atomic<std::uint32_t>::is_always_lock_free and
+                    std::atomic<pid_t>::is_always_lock_free,
+                "pr::epoch_domain requires address-free atomics");
+
+  // an owner while the slot is being evicted, which no process can have
+  static constexpr pid_t evicting = -1;
+
+  struct alignas(64) slot_ {
+    // the announced epoch shifted left by one, with the low bit set while the
+    // owner is inside a critical section
+    std::atomic<std::uint64_t> state{0};
+    std::atomic<pid_t> owner{0};
+    // stall detection, which tolerates races between concurrent collectors
+    std::atomic<std::uint64_t> observed{0};
+    std::atomic<std::uint32_t> attempts{0};
+    // only accessed by the owner, or by an evictor once the owner is gone
+    offset_ptr<epoch_node> retired;
+  };
+
+  std::atomic<std::uint64_t> epoch_{0};
+  std::uint32_t stall_threshold_;
+  std::array<slot_, MaxParticipants> slots_;
+
+  /**
+   * Links the list `nodes` in front of `list`.
+   */
+  static void splice(offset_ptr<epoch_node> &list, epoch_node *nodes) noexcept {
+    if (nodes == nullptr) {
+      return;
+    }
+
+    auto *tail = nodes;
+
+    while (tail->next) {
+      tail = tail->next.get();
+    }
+
+    tail->next = list;
+    list = nodes;
+  }
+
+  /**
+   * Takes the retired nodes of the stalled participant in `slots_[index]` and
+   * frees the slot, unless it changed since it was observed.
+   */
+  [[nodiscard]] auto evict(std::size_t index, pid_t owner,
+                           std::uint64_t state) noexcept -> epoch_node * {
+    auto &slot = slots_[index];
+
+    if (not slot.owner.compare_exchange_strong(owner, evicting,
+                                               std::memory_order_acquire)) {
+      return nullptr;
+    }
+
+    if (slot.state.load(std::memory_order_relaxed) != state) {
+      slot.owner.store(owner, std::memory_order_release);
+      return nullptr;
+    }
+
+    auto *retired = slot.retired.get();
+    slot.retired = nullptr;
+    slot.state.store(0, std::memory_order_relaxed);
+    slot.attempts.store(0, std::memory_order_relaxed);
+    slot.owner.store(0, std::memory_order_release);
+    return retired;
+  }
+
+  /**
+   * Advances the global epoch if every active participant has announced it,
+   * reporting participants which block it to `on_stall`. Returns the retired
+   * nodes of evicted participants.
+   */
+  template <class F>
+  [[nodiscard]] auto try_advance(F &on_stall) noexcept -> epoch_node * {
+    auto epoch = epoch_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    offset_ptr<epoch_node> adopted;
+    bool blocked = false;
+
+    for (std::size_t index = 0; index < MaxParticipants; ++index) {
+      auto &slot = slots_[index];
+      const auto owner = slot.owner.load(std::memory_order_acquire);
+      const auto state = slot.state.load(std::memory_order_acquire);
+
+      if (owner == 0 or (state & 1U) == 0 or state >> 1U == epoch) {
+        continue;
+      }
+
+      blocked = true;
+
+      std::uint32_t attempts = 1;
+
+      if (slot.observed.exchange(state, std::memory_order_relaxed) == state) {
+        attempts = slot.attempts.fetch_add(1, std::memory_order_relaxed) + 1;
+      } else {
+        slot.attempts.store(1, std::memory_order_relaxed);
+      }
+
+      if (attempts < stall_threshold_) {
+        continue;
+      }
+
+      const epoch_stall stall{
+          .slot = index,
+          .owner = owner,
+          .epoch = state >> 1U,
+          .attempts = attempts,
+      };
+
+      if (std::invoke(on_stall, stall) != epoch_stall_action::evict) {
+        continue;
+      }
+
+      splice(adopted, evict(index, owner, state));
+    }
+
+    if (not blocked) {
+      epoch_.compare_exchange_strong(epoch, epoch + 1,
+                                     std::memory_order_acq_rel,
+                                     std::memory_order_relaxed);
+    }
+
+    return adopted.get();
+  }
+
+public:
+  static constexpr std::size_t max_participants = MaxParticipants;
+
+  explicit epoch_domain(std::uint32_t stall_threshold = 1024) noexcept
+      : stall_threshold_(stall_threshold) {}
+
+  epoch_domain(const epoch_domain &) = delete;
+
+  auto operator=(const epoch_domain &) -> epoch_domain & = delete;
+
+  ~epoch_domain() = default;
+
+  [[nodiscard]] auto epoch() const noexcept -> std::uint64_t {
+    return epoch_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Claims a slot for the calling thread, either a free one or one whose
+   * owner's process has exited according to `pr::evict_if_dead`, whether or
+   * not it died inside a critical section. Every other slot of an exited
+   * process is evicted along the way, and its retired nodes are adopted by the
+   * new participant, as are those of a slot left behind by a participant that
+   * unregistered with nodes still retired. Costs a `kill` call per occupied
+   * slot. Fails with `std::errc::resource_unavailable_try_again` if every slot
+   * is taken by a live process.
+   */
+  [[nodiscard]] auto try_register()
+      -> std::expected<epoch_participant<MaxParticipants>, std::error_code> {
+    const auto pid = getpid();
+    constexpr auto unclaimed = MaxParticipants;
+    auto claimed = unclaimed;
+    offset_ptr<epoch_node> adopted;
+
+    for (std::size_t index = 0; index < MaxParticipants; ++index) {
+      auto &slot = slots_[index];
+      auto owner = slot.owner.load(std::memory_order_acquire);
+      const auto state = slot.state.load(std::memory_order_acquire);
+
+      if (owner != 0 and owner != evicting and
+          evict_if_dead({
+              .slot = index,
+              .owner = owner,
+              .epoch = state >> 1U,
+              .attempts = 0,
+          }) == epoch_stall_action::evict) {
+        if (claimed != unclaimed) {
+          splice(adopted, evict(index, owner, state));
+        } else if (slot.owner.compare_exchange_strong(
+                       owner, pid, std::memory_order_acquire,
+                       std::memory_order_relaxed)) {
+          // the retired nodes stay in the slot and pass to its new owner
+          slot.state.store(0, std::memory_order_relaxed);
+          slot.attempts.store(0, std::memory_order_relaxed);
+          claimed = index;
+        }
+
+        continue;
+      }
+
+      if (owner == 0 and claimed == unclaimed and
+          slot.owner.compare_exchange_strong(owner, pid,
+                                             std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+        claimed = index;
+      }
+    }
+
+    if (claimed == unclaimed) {
+      return std::unexpected(
+          std::make_error_code(std::errc::resource_unavailable_try_again));
+    }
+
+    splice(slots_[claimed].retired, adopted.get());
+    return epoch_participant<MaxParticipants>(*this, claimed);
+  }
+};
+
+/**
+ * A process-local handle to a slot of a `pr::epoch_domain`, owned by a single
+ * thread at a time. Unregisters on destruction.
+ */
+template <std::size_t MaxParticipants>
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+class epoch_participant {
+  friend epoch_domain<MaxParticipants>;
+
+  using domain_type = epoch_domain<MaxParticipants>;
+  using slot_type = domain_type::slot_;
+
+  epoch_domain<MaxParticipants> *domain_;
+  std::size_t index_;
+  std::uint32_t depth_ = 0;
+
+  epoch_participant(epoch_domain<MaxParticipants> &domain,
+                    std::size_t index) noexcept
+      : domain_(std::addressof(domain)), index_(index) {}
+
+  [[nodiscard]] auto slot() const noexcept -> slot_type & {
+    return domain_->slots_[index_];
+  }
+
+  void exit() noexcept {
+    if (--depth_ == 0) {
+      const auto state = slot().state.load(std::memory_order_relaxed);
+      slot().state.store(state & ~std::uint64_t{1}, std::memory_order_release);
+    }
+  }
+
+public:
+  /**
+   * A critical section, during which nodes reachable from the shared
+   * structures will not be reclaimed. Critical sections may nest.
+   */
+  class [[nodiscard]] guard {
+    friend epoch_participant;
+
+    epoch_participant *participant_;
+
+    explicit guard(epoch_participant &participant) noexcept
+        : participant_(std::addressof(participant)) {}
+
+  public:
+    guard(const guard &) = delete;
+
+    auto operator=(const guard &) -> guard & = delete;
+
+    ~guard() { participant_->exit(); }
+  };
+
+  epoch_participant(epoch_participant &&other) noexcept
+      : domain_(std::exchange(other.domain_, nullptr)), index_(other.index_),
+        depth_(std::exchange(other.depth_, 0)) {}
+
+  auto operator=(epoch_participant &&other) noexcept -> epoch_participant & {
+    std::destroy_at(this);
+    std::construct_at(this, std::move(other));
+    return *this;
+  }
+
+  ~epoch_participant() {
+    if (domain_ == nullptr) {
+      return;
+    }
+
+    slot().state.store(0, std::memory_order_relaxed);
+    slot().owner.store(0, std::memory_order_release);
+  }
+
+  [[nodiscard]] auto slot_index() const noexcept -> std::size_t {
+    return index_;
+  }
+
+  [[nodiscard]] auto enter() noexcept -> guard {
+    if (depth_++ == 0) {
+      const auto epoch = domain_->epoch_.load(std::memory_order_relaxed);
+      slot().state.store((epoch << 1U) | 1U, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    return guard(*this);
+  }
+
+  /**
+   * Retires `node`, which must already be unreachable from the shared
+   * structures, so that `collect` reclaims it once no critical section can
+   * still observe it.
+   */
+  void retire(epoch_node &node) noexcept {
+    // orders the caller's unlink before reading the epoch, so that no reader
+    // announcing a later epoch can still find `node`
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    node.epoch = domain_->epoch_.load(std::memory_order_relaxed);
+    node.next = slot().retired;
+    slot().retired = std::addressof(node);
+  }
+
+  /**
+   * Attempts to advance the global epoch, then passes each retired node which
+   * is safe to reclaim to `reclaim` and returns how many there were. Retired
+   * nodes of participants evicted by `on_stall` are adopted by this one.
+   * `on_stall` must return `epoch_stall_action::evict` only for participants
+   * whose process has exited, as `pr::evict_if_dead` does.
+   */
+  template <std::invocable<epoch_node &> F,
+            std::invocable<const epoch_stall &> G = decltype(&evict_if_dead)>
+  auto collect(F reclaim, G on_stall = evict_if_dead) -> std::size_t {
+    domain_type::splice(slot().retired, domain_->try_advance(on_stall));
+
+    const auto epoch = domain_->epoch_.load(std::memory_order_acquire);
+    std::size_t reclaimed = 0;
+    auto *link = std::addressof(slot().retired);
+
+    while (auto *node = link->get()) {
+      if (node->epoch + 2 > epoch) {
+        link = std::addressof(node->next);
+        continue;
+      }
+
+      *link = node->next;
+      std::invoke(reclaim, *node);
+      ++reclaimed;
+    }
+
+    return reclaimed;
+  }
+};
+
+} // namespace pr
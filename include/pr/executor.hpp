@@ -0,0 +1,215 @@
+#pragma once
+
+#include <pr/context.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace pr {
+
+/**
+ * A fixed-size thread pool in which each worker owns a deque of tasks. Tasks
+ * posted from a worker are pushed onto and popped from the back of its own
+ * deque, while idle workers steal from the front of the others. Pending tasks
+ * are drained before the destructor joins the workers.
+ */
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+class work_stealing_executor {
+  using task_type = std::move_only_function<void()>;
+
+  struct worker_ {
+    std::mutex mutex;
+    std::deque<task_type> tasks;
+  };
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+  static inline thread_local const work_stealing_executor *current_executor_ =
+      nullptr;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+  static inline thread_local worker_ *current_worker_ = nullptr;
+
+  std::vector<std::unique_ptr<worker_>> workers_;
+  std::atomic<std::size_t> pending_{0};
+  // bumped by every push and by shutdown, and never reset, so that a worker
+  // which read it before either cannot sleep through the notification
+  std::atomic<std::uint64_t> generation_{0};
+  std::atomic<std::size_t> next_{0};
+  std::atomic<bool> stopping_{false};
+  std::vector<std::jthread> threads_;
+
+  [[nodiscard]] static auto try_pop_back(worker_ &worker)
+      -> std::optional<task_type> {
+    const std::scoped_lock lock(worker.mutex);
+
+    if (worker.tasks.empty()) {
+      return std::nullopt;
+    }
+
+    auto task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return task;
+  }
+
+  [[nodiscard]] static auto try_pop_front(worker_ &worker)
+      -> std::optional<task_type> {
+    const std::unique_lock lock(worker.mutex, std::try_to_lock);
+
+    if (not lock or worker.tasks.empty()) {
+      return std::nullopt;
+    }
+
+    auto task = std::move(worker.tasks.front());
+    worker.tasks.pop_front();
+    return task;
+  }
+
+  [[nodiscard]] auto try_take(std::size_t index) -> std::optional<task_type> {
+    if (auto task = try_pop_back(*workers_[index])) {
+      return task;
+    }
+
+    for (std::size_t offset = 1; offset < workers_.size(); ++offset) {
+      const auto victim = (index + offset) % workers_.size();
+
+      if (auto task = try_pop_front(*workers_[victim])) {
+        return task;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  void run(std::size_t index) {
+    current_executor_ = this;
+    current_worker_ = workers_[index].get();
+
+    while (true) {
+      const auto generation = generation_.load(std::memory_order_acquire);
+
+      if (auto task = try_take(index)) {
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        (*task)();
+        continue;
+      }
+
+      const auto pending = pending_.load(std::memory_order_acquire);
+
+      if (pending != 0) {
+        // a task is in flight between its push and our steal attempt
+        std::this_thread::yield();
+      } else if (stopping_.load(std::memory_order_acquire)) {
+        break;
+      } else {
+        generation_.wait(generation, std::memory_order_acquire);
+      }
+    }
+
+    current_executor_ = nullptr;
+    current_worker_ = nullptr;
+  }
+
+  void push(task_type task) {
+    auto *worker = current_worker_;
+
+    if (current_executor_ != this) {
+      const auto index = next_.fetch_add(1, std::memory_order_relaxed);
+      worker = workers_[index % workers_.size()].get();
+    }
+
+    {
+      const std::scoped_lock lock(worker->mutex);
+      worker->tasks.push_back(std::move(task));
+    }
+
+    pending_.fetch_add(1, std::memory_order_release);
+    generation_.fetch_add(1, std::memory_order_release);
+    generation_.notify_one();
+  }
+
+public:
+  explicit work_stealing_executor(
+      std::size_t concurrency = std::max(1U,
+                                         std::thread::hardware_concurrency())) {
+    concurrency = std::max<std::size_t>(concurrency, 1);
+    workers_.reserve(concurrency);
+    threads_.reserve(concurrency);
+
+    for (std::size_t index = 0; index < concurrency; ++index) {
+      workers_.push_back(std::make_unique<worker_>());
+    }
+
+    for (std::size_t index = 0; index < concurrency; ++index) {
+      threads_.emplace_back([this, index] { run(index); });
+    }
+  }
+
+  work_stealing_executor(const work_stealing_executor &) = delete;
+  work_stealing_executor(work_stealing_executor &&) = delete;
+
+  ~work_stealing_executor() {
+    // workers exit once they observe `stopping_` with no task pending
+    stopping_.store(true, std::memory_order_release);
+    generation_.fetch_add(1, std::memory_order_release);
+    generation_.notify_all();
+    threads_.clear();
+  }
+
+  [[nodiscard]] auto concurrency() const noexcept -> std::size_t {
+    return workers_.size();
+  }
+
+  /**
+   * Enqueues `fn` for execution on one of the workers. The contexts
+   * `context_<Ts>...` of the calling thread are captured by
+   * `pr::capture_context<Ts...>()` and reinstated by `pr::restore_context`
+   * around the invocation of `fn`.
+   */
+  template <detail::storable_... Ts, class F>
+    requires detail::distinct_<Ts...> and
+             std::invocable<std::decay_t<F> &> and
+             std::constructible_from<std::decay_t<F>, F>
+  void post(F &&fn) {
+    if constexpr (sizeof...(Ts) == 0) {
+      push(task_type(std::forward<F>(fn)));
+    } else {
+      push(task_type([contexts = capture_context<Ts...>(),
+                      fn = std::decay_t<F>(std::forward<F>(fn))]() mutable {
+        const auto scope = restore_context(contexts);
+        std::invoke(fn);
+      }));
+    }
+  }
+
+  /**
+   * Returns an awaitable that resumes the awaiting coroutine on one of the
+   * workers.
+   */
+  [[nodiscard]] auto schedule() noexcept {
+    struct awaiter {
+      work_stealing_executor *executor;
+
+      [[nodiscard]] static constexpr auto await_ready() noexcept -> bool {
+        return false;
+      }
+
+      void await_suspend(std::coroutine_handle<> handle) const {
+        executor->post([handle] { handle.resume(); });
+      }
+
+      static constexpr void await_resume() noexcept {}
+    };
+
+    return awaiter{this};
+  }
+};
+
+} // namespace pr
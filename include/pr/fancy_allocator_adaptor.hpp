@@ -4,6 +4,55 @@
 
 namespace pr {
 
+#if defined(__cpp_lib_allocate_at_least)
+using std::allocation_result;
+#else
+template <class Pointer, class SizeType = std::size_t>
+struct allocation_result {
+  Pointer ptr;
+  SizeType count;
+};
+#endif
+
+/**
+ * Returns `alloc.allocate_at_least(n)` if that is a well-formed expression,
+ * which may report more than `n` elements of usable storage, or
+ * `{std::allocator_traits<Alloc>::allocate(alloc, n), n}` otherwise.
+ */
+template <class Alloc>
+[[nodiscard]] constexpr auto
+allocate_at_least(Alloc &alloc,
+                  typename std::allocator_traits<Alloc>::size_type n)
+    -> allocation_result<typename std::allocator_traits<Alloc>::pointer,
+                         typename std::allocator_traits<Alloc>::size_type> {
+  using alloc_traits = std::allocator_traits<Alloc>;
+
+  if constexpr (requires { alloc.allocate_at_least(n); }) {
+    auto [ptr, count] = alloc.allocate_at_least(n);
+    return {std::move(ptr), static_cast<alloc_traits::size_type>(count)};
+  } else {
+    return {alloc_traits::allocate(alloc, n), n};
+  }
+}
+
+/**
+ * Returns `alloc.try_expand(p, old_n, new_n)` if that is a well-formed
+ * expression, or `false` otherwise. On success, the storage at `p` which was
+ * obtained with a size of `old_n` holds `new_n` elements and must be
+ * deallocated with a size of `new_n`. On failure, it is unchanged.
+ */
+template <class Alloc>
+[[nodiscard]] constexpr auto
+try_expand(Alloc &alloc, typename std::allocator_traits<Alloc>::pointer p,
+           typename std::allocator_traits<Alloc>::size_type old_n,
+           typename std::allocator_traits<Alloc>::size_type new_n) -> bool {
+  if constexpr (requires { alloc.try_expand(p, old_n, new_n); }) {
+    return alloc.try_expand(std::move(p), old_n, new_n);
+  } else {
+    return false;
+  }
+}
+
 template <class Allocator, class Pointer>
 // NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
 class fancy_allocator_adaptor : public Allocator {
@@ -54,12 +103,26 @@ public:
     return pointer(alloc_traits::allocate(*this, n));
   }
 
+  [[nodiscard]] constexpr auto allocate_at_least(size_type n)
+      -> allocation_result<pointer, size_type> {
+    auto [ptr, count] = pr::allocate_at_least<Allocator>(*this, n);
+    return {pointer(ptr), count};
+  }
+
   constexpr void deallocate(pointer p, size_type n) {
     using base_pointer = alloc_traits::pointer;
     using base_traits = std::pointer_traits<base_pointer>;
     alloc_traits::deallocate(*this, base_traits::pointer_to(*p), n);
   }
 
+  [[nodiscard]] constexpr auto try_expand(pointer p, size_type old_n,
+                                          size_type new_n) -> bool {
+    using base_pointer = alloc_traits::pointer;
+    using base_traits = std::pointer_traits<base_pointer>;
+    return pr::try_expand<Allocator>(*this, base_traits::pointer_to(*p), old_n,
+                                     new_n);
+  }
+
   template <class T, class... Args>
   constexpr void construct(T *p, Args &&...args) {
     alloc_traits::construct(*this, p, std::forward<Args>(args)...);
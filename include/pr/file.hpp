@@ -1,10 +1,12 @@
 #pragma once
 
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <expected>
 #include <optional>
+#include <span>
 #include <system_error>
 #include <utility>
 
@@ -60,6 +62,56 @@ public:
     return std::exchange(descriptor, std::nullopt);
   }
 
+  /**
+   * Takes ownership of `fd`, the result of a call which returns `-1` and sets
+   * `errno` on failure.
+   */
+  [[nodiscard]] static constexpr auto try_adopt(int fd)
+      -> std::expected<file, std::error_code> {
+    return file_or_error_code_from(fd);
+  }
+
+  [[nodiscard]] auto try_write(std::span<const std::byte> bytes) const
+      -> std::expected<std::size_t, std::error_code> {
+    const auto count = write(**this, bytes.data(), bytes.size());
+
+    if (count == -1) {
+      return std::unexpected(std::make_error_code(std::errc(errno)));
+    }
+
+    return static_cast<std::size_t>(count);
+  }
+
+  /**
+   * Calls `try_write` until every byte of `bytes` has been written, retrying
+   * when interrupted by a signal.
+   */
+  [[nodiscard]] auto try_write_all(std::span<const std::byte> bytes) const
+      -> std::expected<void, std::error_code> {
+    while (not bytes.empty()) {
+      const auto count = try_write(bytes);
+
+      if (count) {
+        bytes = bytes.subspan(*count);
+      } else if (count.error() != std::errc::interrupted) {
+        return std::unexpected(count.error());
+      }
+    }
+
+    return {};
+  }
+
+  [[nodiscard]] auto try_size() const
+      -> std::expected<std::size_t, std::error_code> {
+    struct stat status {};
+
+    if (fstat(**this, &status) == -1) {
+      return std::unexpected(std::make_error_code(std::errc(errno)));
+    }
+
+    return static_cast<std::size_t>(status.st_size);
+  }
+
   [[nodiscard]] static auto try_open(const char *path, int flags)
       -> std::expected<file, std::error_code> {
     // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
@@ -0,0 +1,399 @@
+#pragma once
+
+#include <pr/file.hpp>
+#include <pr/mapping.hpp>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) or defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace pr {
+
+enum class perf_event : std::uint8_t {
+  cycles,
+  instructions,
+  cache_misses,
+  branch_misses,
+  page_faults,
+};
+
+inline constexpr std::size_t perf_event_count = 5;
+
+inline constexpr std::array<perf_event, perf_event_count> all_perf_events{
+    perf_event::cycles,        perf_event::instructions,
+    perf_event::cache_misses,  perf_event::branch_misses,
+    perf_event::page_faults,
+};
+
+struct perf_reading {
+  std::uint64_t time_enabled = 0;
+  std::uint64_t time_running = 0;
+  std::array<std::optional<std::uint64_t>, perf_event_count> values{};
+
+  [[nodiscard]] constexpr auto operator[](perf_event event) const noexcept
+      -> std::optional<std::uint64_t> {
+    return values[std::to_underlying(event)];
+  }
+};
+
+/**
+ * An RAII group of `perf_event_open` counters measuring the calling thread in
+ * user space. Hardware events that cannot be opened, e.g. inside a virtual
+ * machine without a virtual PMU, fall back to the software event
+ * `PERF_COUNT_SW_TASK_CLOCK` in nanoseconds for `perf_event::cycles` and are
+ * left out otherwise; `is_software(event)` reports which. The group is created
+ * disabled.
+ */
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+class perf_counters {
+  struct counter_ {
+    perf_event event;
+    bool software;
+    std::uint64_t id;
+    file descriptor;
+    std::optional<mapping> page;
+  };
+
+  // `perf_event_attr::type` and `perf_event_attr::config`
+  using config_type = std::pair<std::uint32_t, std::uint64_t>;
+
+  std::vector<counter_> counters_;
+
+  explicit perf_counters(std::vector<counter_> counters) noexcept
+      : counters_(std::move(counters)) {}
+
+  [[nodiscard]] static constexpr auto hardware_config(perf_event event) noexcept
+      -> std::optional<config_type> {
+    switch (event) {
+    case perf_event::cycles:
+      return {{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}};
+    case perf_event::instructions:
+      return {{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}};
+    case perf_event::cache_misses:
+      return {{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}};
+    case perf_event::branch_misses:
+      return {{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}};
+    case perf_event::page_faults:
+      return std::nullopt;
+    }
+
+    return std::nullopt;
+  }
+
+  [[nodiscard]] static constexpr auto software_config(perf_event event) noexcept
+      -> std::optional<config_type> {
+    switch (event) {
+    case perf_event::cycles:
+      return {{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}};
+    case perf_event::page_faults:
+      return {{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}};
+    default:
+      return std::nullopt;
+    }
+  }
+
+  [[nodiscard]] static auto try_open_one(std::uint32_t type,
+                                         std::uint64_t config, int group_fd)
+      -> std::expected<file, std::error_code> {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group_fd == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                       PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    return file::try_adopt(static_cast<int>(syscall(SYS_perf_event_open,
+                                                    &attr, 0, -1, group_fd,
+                                                    PERF_FLAG_FD_CLOEXEC)));
+  }
+
+  [[nodiscard]] auto leader() const noexcept -> int {
+    return *counters_.front().descriptor;
+  }
+
+  [[nodiscard]] auto try_ioctl(unsigned long request) const
+      -> std::expected<void, std::error_code> {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    if (ioctl(leader(), request, PERF_IOC_FLAG_GROUP) == -1) {
+      return std::unexpected(std::make_error_code(std::errc(errno)));
+    }
+
+    return {};
+  }
+
+  [[nodiscard]] auto find(perf_event event) const noexcept -> const counter_ * {
+    for (const auto &counter : counters_) {
+      if (counter.event == event) {
+        return &counter;
+      }
+    }
+
+    return nullptr;
+  }
+
+#if defined(__x86_64__) or defined(__i386__)
+  /**
+   * Reads a counter with `rdpmc` following the seqlock protocol documented for
+   * `struct perf_event_mmap_page`.
+   */
+  [[nodiscard]] static auto try_rdpmc(const mapping &page) noexcept
+      -> std::optional<std::uint64_t> {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const auto *header =
+        reinterpret_cast<const volatile perf_event_mmap_page *>(page.data());
+
+    while (true) {
+      const std::uint32_t sequence = header->lock;
+      std::atomic_signal_fence(std::memory_order_acquire);
+
+      const std::uint32_t index = header->index;
+
+      if (header->cap_user_rdpmc == 0 or index == 0) {
+        return std::nullopt;
+      }
+
+      const auto width = header->pmc_width;
+      auto count = static_cast<std::int64_t>(
+          __rdpmc(static_cast<int>(index - 1)));
+      count = static_cast<std::int64_t>(static_cast<std::uint64_t>(count)
+                                        << (64U - width)) >>
+              (64U - width);
+      count += header->offset;
+
+      std::atomic_signal_fence(std::memory_order_acquire);
+
+      if (header->lock == sequence) {
+        return static_cast<std::uint64_t>(count);
+      }
+    }
+  }
+#endif
+
+public:
+  perf_counters(perf_counters &&other) noexcept = default;
+
+  auto operator=(perf_counters &&other) noexcept -> perf_counters & {
+    std::destroy_at(this);
+    std::construct_at(this, std::move(other));
+    return *this;
+  }
+
+  ~perf_counters() = default;
+
+  /**
+   * Opens a group counting `events` for the calling thread. When
+   * `map_user_pages` is set, each counter's mmap page is mapped with
+   * `pr::mapping` so that `read_user` can use `rdpmc` instead of a syscall.
+   * Fails with `std::errc::invalid_argument` if `events` repeats an event, so
+   * that a group never holds more than `perf_event_count` counters, and
+   * otherwise only if none of `events` could be opened.
+   */
+  [[nodiscard]] static auto
+  try_open(std::span<const perf_event> events = all_perf_events,
+           bool map_user_pages = true)
+      -> std::expected<perf_counters, std::error_code> {
+    std::vector<counter_> counters;
+    auto last_error = std::make_error_code(std::errc::invalid_argument);
+    const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    std::array<bool, perf_event_count> requested{};
+
+    for (const auto event : events) {
+      if (std::exchange(requested[std::to_underlying(event)], true)) {
+        return std::unexpected(
+            std::make_error_code(std::errc::invalid_argument));
+      }
+    }
+
+    for (const auto event : events) {
+      const int group_fd =
+          counters.empty() ? -1 : *counters.front().descriptor;
+      bool software = false;
+      auto descriptor = std::expected<file, std::error_code>(
+          std::unexpect, std::make_error_code(std::errc::not_supported));
+
+      if (const auto config = hardware_config(event)) {
+        descriptor = try_open_one(config->first, config->second, group_fd);
+      }
+
+      if (not descriptor) {
+        if (const auto config = software_config(event)) {
+          software = true;
+          descriptor = try_open_one(config->first, config->second, group_fd);
+        }
+      }
+
+      if (not descriptor) {
+        last_error = descriptor.error();
+        continue;
+      }
+
+      std::uint64_t id = 0;
+
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+      if (ioctl(**descriptor, PERF_EVENT_IOC_ID, &id) == -1) {
+        return std::unexpected(std::make_error_code(std::errc(errno)));
+      }
+
+      std::optional<mapping> page;
+
+      if (map_user_pages and not software) {
+        if (auto mapped = mapping::try_mmap(nullptr, page_size,
+                                            {
+                                                .prot = PROT_READ,
+                                                .flags = MAP_SHARED,
+                                                .fd = **descriptor,
+                                            })) {
+          page.emplace(std::move(*mapped));
+        }
+      }
+
+      counters.push_back({
+          .event = event,
+          .software = software,
+          .id = id,
+          .descriptor = std::move(*descriptor),
+          .page = std::move(page),
+      });
+    }
+
+    if (counters.empty()) {
+      return std::unexpected(last_error);
+    }
+
+    return perf_counters{std::move(counters)};
+  }
+
+  [[nodiscard]] auto contains(perf_event event) const noexcept -> bool {
+    return find(event) != nullptr;
+  }
+
+  [[nodiscard]] auto is_software(perf_event event) const noexcept -> bool {
+    const auto *counter = find(event);
+    return counter != nullptr and counter->software;
+  }
+
+  [[nodiscard]] auto try_reset() const
+      -> std::expected<void, std::error_code> {
+    return try_ioctl(PERF_EVENT_IOC_RESET);
+  }
+
+  [[nodiscard]] auto try_enable() const
+      -> std::expected<void, std::error_code> {
+    return try_ioctl(PERF_EVENT_IOC_ENABLE);
+  }
+
+  [[nodiscard]] auto try_disable() const
+      -> std::expected<void, std::error_code> {
+    return try_ioctl(PERF_EVENT_IOC_DISABLE);
+  }
+
+  /**
+   * Reads every counter of the group with a single `read` syscall.
+   */
+  [[nodiscard]] auto try_read() const
+      -> std::expected<perf_reading, std::error_code> {
+    // nr, time_enabled, time_running, then a value and id for each counter,
+    // of which `try_open` opens at most one per event
+    std::array<std::uint64_t, 3 + (2 * perf_event_count)> buffer{};
+    const auto bytes = read(leader(), buffer.data(), sizeof(buffer));
+
+    if (bytes == -1) {
+      return std::unexpected(std::make_error_code(std::errc(errno)));
+    }
+
+    perf_reading reading{
+        .time_enabled = buffer[1],
+        .time_running = buffer[2],
+    };
+
+    const auto count = std::min<std::uint64_t>(buffer[0], perf_event_count);
+
+    for (std::size_t index = 0; index < count; ++index) {
+      const auto value = buffer[3 + (2 * index)];
+      const auto id = buffer[4 + (2 * index)];
+
+      for (const auto &counter : counters_) {
+        if (counter.id == id) {
+          reading.values[std::to_underlying(counter.event)] = value;
+        }
+      }
+    }
+
+    return reading;
+  }
+
+  /**
+   * Reads a single counter from user space with `rdpmc` when its mmap page is
+   * mapped and the kernel permits it, which costs tens of cycles, or with
+   * `try_read` otherwise. Returns `std::nullopt` if `event` is not counted.
+   */
+  [[nodiscard]] auto read_user(perf_event event) const noexcept
+      -> std::optional<std::uint64_t> {
+    const auto *counter = find(event);
+
+    if (counter == nullptr) {
+      return std::nullopt;
+    }
+
+#if defined(__x86_64__) or defined(__i386__)
+    if (counter->page) {
+      if (const auto count = try_rdpmc(*counter->page)) {
+        return count;
+      }
+    }
+#endif
+
+    if (const auto reading = try_read()) {
+      return (*reading)[event];
+    }
+
+    return std::nullopt;
+  }
+
+  /**
+   * Resets and enables the group around a call to `fn`, then returns the
+   * counts it accumulated.
+   */
+  template <std::invocable F>
+  [[nodiscard]] auto try_measure(F &&fn) const
+      -> std::expected<perf_reading, std::error_code> {
+    if (auto reset = try_reset(); not reset) {
+      return std::unexpected(reset.error());
+    }
+
+    if (auto enabled = try_enable(); not enabled) {
+      return std::unexpected(enabled.error());
+    }
+
+    std::invoke(std::forward<F>(fn));
+
+    if (auto disabled = try_disable(); not disabled) {
+      return std::unexpected(disabled.error());
+    }
+
+    return try_read();
+  }
+};
+
+} // namespace pr
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <pr/file.hpp>
+#include <pr/mapping.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <expected>
+#include <span>
+#include <system_error>
+#include <utility>
+
+namespace pr {
+
+/**
+ * A read-only view of a memfd whose contents can no longer change. Its size is
+ * trusted once the seals are verified, since the file can neither shrink
+ * beneath the mapping nor be written through any other descriptor or mapping.
+ */
+class sealed_shared_memory {
+  file descriptor_;
+  mapping memory_;
+
+  sealed_shared_memory(file descriptor, mapping memory) noexcept
+      : descriptor_(std::move(descriptor)), memory_(std::move(memory)) {}
+
+public:
+  static constexpr int required_seals =
+      F_SEAL_WRITE | F_SEAL_GROW | F_SEAL_SHRINK;
+
+  /**
+   * Takes ownership of a descriptor received from another process, e.g. with
+   * `SCM_RIGHTS`, and maps it read-only after checking that it carries every
+   * seal in `required_seals`. Fails with `std::errc::operation_not_permitted`
+   * if it does not.
+   */
+  [[nodiscard]] static auto try_adopt(file descriptor)
+      -> std::expected<sealed_shared_memory, std::error_code> {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    const auto seals = fcntl(*descriptor, F_GET_SEALS);
+
+    if (seals == -1) {
+      return std::unexpected(std::make_error_code(std::errc(errno)));
+    }
+
+    if ((seals & required_seals) != required_seals) {
+      return std::unexpected(
+          std::make_error_code(std::errc::operation_not_permitted));
+    }
+
+    const auto size = descriptor.try_size();
+
+    if (not size) {
+      return std::unexpected(size.error());
+    }
+
+    auto memory = mapping::try_mmap(nullptr, *size,
+                                    {
+                                        .prot = PROT_READ,
+                                        .flags = MAP_PRIVATE,
+                                        .fd = *descriptor,
+                                    });
+
+    if (not memory) {
+      return std::unexpected(memory.error());
+    }
+
+    return sealed_shared_memory{std::move(descriptor), std::move(*memory)};
+  }
+
+  [[nodiscard]] auto descriptor() const noexcept -> const file & {
+    return descriptor_;
+  }
+
+  [[nodiscard]] auto data() const noexcept -> const std::byte * {
+    return memory_.data();
+  }
+
+  [[nodiscard]] auto size() const noexcept -> std::size_t {
+    return static_cast<std::size_t>(memory_.size());
+  }
+
+  [[nodiscard]] auto bytes() const noexcept -> std::span<const std::byte> {
+    return {data(), size()};
+  }
+};
+
+/**
+ * A writable, fixed-size memfd mapped with `pr::mapping`. Once filled, e.g.
+ * with a `pr::arena` whose contents link to each other with `pr::offset_ptr`,
+ * `try_seal` turns it into a `pr::sealed_shared_memory` whose descriptor can be
+ * handed to another process, which maps the same pages without copying.
+ */
+class shared_memory {
+  file descriptor_;
+  mapping memory_;
+
+  shared_memory(file descriptor, mapping memory) noexcept
+      : descriptor_(std::move(descriptor)), memory_(std::move(memory)) {}
+
+public:
+  /**
+   * Creates a memfd of `size` bytes named `name`, which only appears in
+   * `/proc/<pid>/fd` and need not be unique.
+   */
+  [[nodiscard]] static auto try_create(const char *name, std::size_t size)
+      -> std::expected<shared_memory, std::error_code> {
+    if (size == 0) {
+      return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+
+    auto descriptor =
+        file::try_adopt(memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING));
+
+    if (not descriptor) {
+      return std::unexpected(descriptor.error());
+    }
+
+    if (ftruncate(**descriptor, static_cast<off_t>(size)) == -1) {
+      return std::unexpected(std::make_error_code(std::errc(errno)));
+    }
+
+    auto memory = mapping::try_mmap(nullptr, size,
+                                    {
+                                        .prot = PROT_READ | PROT_WRITE,
+                                        .flags = MAP_SHARED,
+                                        .fd = **descriptor,
+                                    });
+
+    if (not memory) {
+      return std::unexpected(memory.error());
+    }
+
+    return shared_memory{std::move(*descriptor), std::move(*memory)};
+  }
+
+  [[nodiscard]] auto descriptor() const noexcept -> const file & {
+    return descriptor_;
+  }
+
+  [[nodiscard]] auto data() const noexcept -> std::byte * {
+    return memory_.data();
+  }
+
+  [[nodiscard]] auto size() const noexcept -> std::size_t {
+    return static_cast<std::size_t>(memory_.size());
+  }
+
+  [[nodiscard]] auto bytes() const noexcept -> std::span<std::byte> {
+    return {data(), size()};
+  }
+
+  /**
+   * Unmaps the writable mapping, which the kernel requires before it grants
+   * `F_SEAL_WRITE`, seals the memfd against writing, resizing and further
+   * sealing, and maps it again read-only. Pointers into `bytes()` are
+   * invalidated; `pr::offset_ptr` links between them are not. The memory is
+   * consumed even on failure.
+   */
+  [[nodiscard]] auto try_seal() && -> std::expected<sealed_shared_memory,
+                                                    std::error_code> {
+    {
+      const auto writable = std::move(memory_);
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    if (fcntl(*descriptor_, F_ADD_SEALS,
+              sealed_shared_memory::required_seals | F_SEAL_SEAL) == -1) {
+      return std::unexpected(std::make_error_code(std::errc(errno)));
+    }
+
+    return sealed_shared_memory::try_adopt(std::move(descriptor_));
+  }
+};
+
+} // namespace pr
@@ -0,0 +1,358 @@
+#pragma once
+
+#include <pr/file.hpp>
+#include <pr/mapping.hpp>
+#include <pr/offset_ptr.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <memory>
+#include <new>
+#include <source_location>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace pr {
+
+enum class snapshot_errc {
+  truncated = 1,
+  bad_magic,
+  unsupported_version,
+  header_checksum_mismatch,
+  fingerprint_mismatch,
+  schema_mismatch,
+  out_of_bounds,
+  misaligned,
+};
+
+namespace detail {
+
+class snapshot_category_ : public std::error_category {
+public:
+  [[nodiscard]] auto name() const noexcept -> const char * override {
+    return "pr::snapshot";
+  }
+
+  [[nodiscard]] auto message(int condition) const -> std::string override {
+    switch (static_cast<snapshot_errc>(condition)) {
+    case snapshot_errc::truncated:
+      return "snapshot is shorter than its header describes";
+    case snapshot_errc::bad_magic:
+      return "not a snapshot";
+    case snapshot_errc::unsupported_version:
+      return "unsupported snapshot format version";
+    case snapshot_errc::header_checksum_mismatch:
+      return "snapshot header checksum mismatch";
+    case snapshot_errc::fingerprint_mismatch:
+      return "snapshot root type fingerprint mismatch";
+    case snapshot_errc::schema_mismatch:
+      return "snapshot schema version mismatch";
+    case snapshot_errc::out_of_bounds:
+      return "snapshot root lies outside of its payload";
+    case snapshot_errc::misaligned:
+      return "snapshot payload or root is misaligned";
+    }
+
+    return "unknown snapshot error";
+  }
+};
+
+[[nodiscard]] constexpr auto fnv1a(std::span<const std::byte> bytes,
+                                   std::uint64_t hash = 0xcbf29ce484222325U)
+    -> std::uint64_t {
+  for (const auto byte : bytes) {
+    hash = (hash ^ static_cast<std::uint64_t>(byte)) * 0x100000001b3U;
+  }
+
+  return hash;
+}
+
+[[nodiscard]] constexpr auto fnv1a(std::string_view text,
+                                   std::uint64_t hash = 0xcbf29ce484222325U)
+    -> std::uint64_t {
+  for (const auto c : text) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3U;
+  }
+
+  return hash;
+}
+
+[[nodiscard]] constexpr auto fnv1a(std::uint64_t value, std::uint64_t hash)
+    -> std::uint64_t {
+  for (std::size_t byte = 0; byte < sizeof(value); ++byte) {
+    hash = (hash ^ ((value >> (8 * byte)) & 0xffU)) * 0x100000001b3U;
+  }
+
+  return hash;
+}
+
+template <class T>
+[[nodiscard]] consteval auto type_signature() -> std::string_view {
+  return std::source_location::current().function_name();
+}
+
+} // namespace detail
+
+[[nodiscard]] inline auto snapshot_category() noexcept
+    -> const std::error_category & {
+  static const detail::snapshot_category_ category;
+  return category;
+}
+
+[[nodiscard]] inline auto make_error_code(snapshot_errc e) noexcept
+    -> std::error_code {
+  return {static_cast<int>(e), snapshot_category()};
+}
+
+/**
+ * A hash of the name of `T` as spelled by the compiler, its size and its
+ * alignment. It detects a snapshot being opened as the wrong root type, but it
+ * is only stable for a given compiler and does not see changes to members
+ * which preserve layout; use the schema version for those.
+ */
+template <class T>
+inline constexpr std::uint64_t type_fingerprint = detail::fnv1a(
+    alignof(T), detail::fnv1a(sizeof(T), detail::fnv1a(
+                                              detail::type_signature<T>())));
+
+/**
+ * The header at offset `0` of a snapshot file. The payload starts at
+ * `payload_offset`, a multiple of `snapshot_header::alignment`, and `root`
+ * points into it once the file is mapped. `header_checksum` covers every
+ * preceding byte of the header.
+ */
+struct snapshot_header {
+  static constexpr std::array<char, 8> expected_magic{'P', 'R', 'S', 'N',
+                                                      'A', 'P', '\0', '\0'};
+  static constexpr std::uint32_t current_version = 1;
+  static constexpr std::size_t alignment = 64;
+
+  std::array<char, 8> magic = expected_magic;
+  std::uint32_t version = current_version;
+  std::uint32_t header_size = sizeof(snapshot_header);
+  std::uint64_t fingerprint = 0;
+  std::uint64_t schema_version = 0;
+  std::uint64_t payload_offset = 0;
+  std::uint64_t payload_size = 0;
+  std::uint64_t payload_checksum = 0;
+  offset_ptr<const std::byte> root;
+  std::uint64_t header_checksum = 0;
+
+  [[nodiscard]] auto checksum() const noexcept -> std::uint64_t {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const auto *bytes = reinterpret_cast<const std::byte *>(this);
+    return detail::fnv1a({bytes, offsetof(snapshot_header, header_checksum)});
+  }
+};
+
+/**
+ * Writes `region` to `output` as the payload of a snapshot whose root object is
+ * `root`, which must lie inside `region`. `region` must start at a multiple of
+ * `snapshot_header::alignment`, as a `pr::mapping` or the data of a
+ * `pr::arena` over one does, and every pointer inside it must be relative,
+ * such as `pr::offset_ptr`.
+ */
+template <class Root>
+[[nodiscard]] auto try_write_snapshot(const file &output,
+                                      std::span<const std::byte> region,
+                                      const Root &root,
+                                      std::uint64_t schema_version = 0)
+    -> std::expected<void, std::error_code> {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto *root_bytes = reinterpret_cast<const std::byte *>(&root);
+  const auto base = reinterpret_cast<std::uintptr_t>(region.data());
+
+  if (base % snapshot_header::alignment != 0) {
+    return std::unexpected(make_error_code(snapshot_errc::misaligned));
+  }
+
+  if (std::less<>{}(root_bytes, region.data()) or
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      std::less<>{}(region.data() + region.size(), root_bytes + sizeof(Root))) {
+    return std::unexpected(make_error_code(snapshot_errc::out_of_bounds));
+  }
+
+  constexpr auto payload_offset =
+      (sizeof(snapshot_header) + snapshot_header::alignment - 1) /
+      snapshot_header::alignment * snapshot_header::alignment;
+
+  alignas(snapshot_header) std::array<std::byte, payload_offset> prefix{};
+  auto *header = std::construct_at(
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      reinterpret_cast<snapshot_header *>(prefix.data()));
+
+  header->fingerprint = type_fingerprint<Root>;
+  header->schema_version = schema_version;
+  header->payload_offset = payload_offset;
+  header->payload_size = region.size();
+  header->payload_checksum = detail::fnv1a(region);
+
+  // the root's position relative to `header->root` once the file is mapped
+  const auto root_offset = static_cast<std::uintptr_t>(
+      payload_offset + static_cast<std::size_t>(root_bytes - region.data()) -
+      offsetof(snapshot_header, root));
+  header->root = offset_ptr<const std::byte>(
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
+      reinterpret_cast<const std::byte *>(
+          reinterpret_cast<std::uintptr_t>(&header->root) + root_offset));
+  header->header_checksum = header->checksum();
+
+  if (auto written = output.try_write_all(prefix); not written) {
+    return written;
+  }
+
+  return output.try_write_all(region);
+}
+
+/**
+ * A read-only mapping of a snapshot written by `pr::try_write_snapshot` with a
+ * root of type `Root`. Loading validates the header, the root type, the
+ * schema version and the bounds and alignment of the root in constant time,
+ * touching only the first page; `verify_payload` checks the payload checksum
+ * on demand.
+ */
+template <class Root>
+class snapshot {
+  mapping memory_;
+
+  explicit snapshot(mapping memory) noexcept : memory_(std::move(memory)) {}
+
+  [[nodiscard]] static auto
+  validate(const mapping &memory, std::uint64_t schema_version) noexcept
+      -> std::error_code {
+    const auto size = static_cast<std::size_t>(memory.size());
+
+    if (size < sizeof(snapshot_header)) {
+      return make_error_code(snapshot_errc::truncated);
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const auto &header = *std::launder(
+        reinterpret_cast<const snapshot_header *>(memory.data()));
+
+    if (header.magic != snapshot_header::expected_magic) {
+      return make_error_code(snapshot_errc::bad_magic);
+    }
+
+    if (header.version != snapshot_header::current_version or
+        header.header_size != sizeof(snapshot_header)) {
+      return make_error_code(snapshot_errc::unsupported_version);
+    }
+
+    if (header.header_checksum != header.checksum()) {
+      return make_error_code(snapshot_errc::header_checksum_mismatch);
+    }
+
+    if (header.fingerprint != type_fingerprint<Root>) {
+      return make_error_code(snapshot_errc::fingerprint_mismatch);
+    }
+
+    if (header.schema_version != schema_version) {
+      return make_error_code(snapshot_errc::schema_mismatch);
+    }
+
+    if (header.payload_offset % snapshot_header::alignment != 0 or
+        header.payload_offset < sizeof(snapshot_header)) {
+      return make_error_code(snapshot_errc::misaligned);
+    }
+
+    if (header.payload_offset > size or
+        header.payload_size != size - header.payload_offset) {
+      return make_error_code(snapshot_errc::truncated);
+    }
+
+    // compare addresses as integers, since `root` may point anywhere
+    const auto payload =
+        reinterpret_cast<std::uintptr_t>(memory.data()) + header.payload_offset;
+    const auto root = reinterpret_cast<std::uintptr_t>(header.root.get());
+
+    if (not header.root or root < payload or
+        header.payload_size < sizeof(Root) or
+        root - payload > header.payload_size - sizeof(Root)) {
+      return make_error_code(snapshot_errc::out_of_bounds);
+    }
+
+    if (root % alignof(Root) != 0) {
+      return make_error_code(snapshot_errc::misaligned);
+    }
+
+    return {};
+  }
+
+public:
+  [[nodiscard]] static auto try_load(const file &input,
+                                     std::uint64_t schema_version = 0)
+      -> std::expected<snapshot, std::error_code> {
+    const auto size = input.try_size();
+
+    if (not size) {
+      return std::unexpected(size.error());
+    }
+
+    if (*size < sizeof(snapshot_header)) {
+      return std::unexpected(make_error_code(snapshot_errc::truncated));
+    }
+
+    auto memory = mapping::try_mmap(nullptr, *size,
+                                    {
+                                        .prot = PROT_READ,
+                                        .flags = MAP_PRIVATE,
+                                        .fd = *input,
+                                    });
+
+    if (not memory) {
+      return std::unexpected(memory.error());
+    }
+
+    if (const auto error = validate(*memory, schema_version)) {
+      return std::unexpected(error);
+    }
+
+    return snapshot{std::move(*memory)};
+  }
+
+  [[nodiscard]] static auto try_load(const char *path,
+                                     std::uint64_t schema_version = 0)
+      -> std::expected<snapshot, std::error_code> {
+    const auto input = file::try_open(path, O_RDONLY | O_CLOEXEC);
+
+    if (not input) {
+      return std::unexpected(input.error());
+    }
+
+    return try_load(*input, schema_version);
+  }
+
+  [[nodiscard]] auto header() const noexcept -> const snapshot_header & {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return *std::launder(
+        reinterpret_cast<const snapshot_header *>(memory_.data()));
+  }
+
+  [[nodiscard]] auto payload() const noexcept -> std::span<const std::byte> {
+    return std::span<const std::byte>(memory_).subspan(
+        header().payload_offset, header().payload_size);
+  }
+
+  [[nodiscard]] auto root() const noexcept -> const Root & {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return *std::launder(reinterpret_cast<const Root *>(header().root.get()));
+  }
+
+  /**
+   * Recomputes the payload checksum, reading every page of the payload.
+   */
+  [[nodiscard]] auto verify_payload() const noexcept -> bool {
+    return detail::fnv1a(payload()) == header().payload_checksum;
+  }
+};
+
+} // namespace pr
+
+template <>
+struct std::is_error_code_enum<pr::snapshot_errc> : std::true_type {};
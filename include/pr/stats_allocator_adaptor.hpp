@@ -0,0 +1,423 @@
+#pragma once
+
+#include <pr/context.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+namespace pr {
+
+/**
+ * Size classes and lifetime buckets are powers of two: class `i` counts
+ * allocations of `[2^i, 2^(i+1))` bytes, and bucket `i` counts blocks that
+ * lived for `[2^i, 2^(i+1))` nanoseconds.
+ */
+inline constexpr std::size_t allocation_stats_buckets = 48;
+
+struct allocation_stats_snapshot {
+  struct size_class {
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t allocated_bytes = 0;
+    std::uint64_t deallocated_bytes = 0;
+  };
+
+  std::uint64_t allocations = 0;
+  std::uint64_t deallocations = 0;
+  std::uint64_t allocated_bytes = 0;
+  std::uint64_t deallocated_bytes = 0;
+  std::uint64_t live_bytes = 0;
+  std::uint64_t high_water_bytes = 0;
+  std::array<size_class, allocation_stats_buckets> size_classes{};
+  std::array<std::uint64_t, allocation_stats_buckets> lifetimes{};
+
+  [[nodiscard]] auto to_json() const -> std::string {
+    std::string json;
+
+    const auto append = [&json](std::uint64_t value) {
+      std::array<char, 24> chars{};
+      const auto [end, ec] =
+          std::to_chars(chars.data(), chars.data() + chars.size(), value);
+      json.append(chars.data(), end);
+    };
+
+    json += R"({"allocations":)";
+    append(allocations);
+    json += R"(,"deallocations":)";
+    append(deallocations);
+    json += R"(,"allocated_bytes":)";
+    append(allocated_bytes);
+    json += R"(,"deallocated_bytes":)";
+    append(deallocated_bytes);
+    json += R"(,"live_bytes":)";
+    append(live_bytes);
+    json += R"(,"high_water_bytes":)";
+    append(high_water_bytes);
+    json += R"(,"size_classes":[)";
+
+    bool first = true;
+
+    for (std::size_t index = 0; index < size_classes.size(); ++index) {
+      const auto &size = size_classes[index];
+
+      if (size.allocations == 0 and size.deallocations == 0) {
+        continue;
+      }
+
+      json += first ? R"({"min_bytes":)" : R"(,{"min_bytes":)";
+      first = false;
+      append(std::uint64_t{1} << index);
+      json += R"(,"allocations":)";
+      append(size.allocations);
+      json += R"(,"deallocations":)";
+      append(size.deallocations);
+      json += R"(,"allocated_bytes":)";
+      append(size.allocated_bytes);
+      json += R"(,"deallocated_bytes":)";
+      append(size.deallocated_bytes);
+      json += '}';
+    }
+
+    json += R"(],"lifetimes":[)";
+    first = true;
+
+    for (std::size_t index = 0; index < lifetimes.size(); ++index) {
+      if (lifetimes[index] == 0) {
+        continue;
+      }
+
+      json += first ? R"({"min_ns":)" : R"(,{"min_ns":)";
+      first = false;
+      append(std::uint64_t{1} << index);
+      json += R"(,"count":)";
+      append(lifetimes[index]);
+      json += '}';
+    }
+
+    json += "]}";
+    return json;
+  }
+};
+
+/**
+ * Counters shared by every copy and rebind of a `pr::stats_allocator_adaptor`
+ * constructed from it. Updates go to one of several cache-line-aligned shards
+ * chosen per thread with relaxed atomics, so threads rarely contend. Live bytes
+ * are published in batches of `batch_bytes` per shard. Between batches, each
+ * shard records the peak of the published live bytes plus its own unpublished
+ * ones. The high-water mark is therefore exact while only one shard holds
+ * unpublished bytes, as when a single thread allocates, and otherwise off by
+ * less than `(shard_count - 1) * batch_bytes`, the most the other shards can
+ * hold unpublished.
+ */
+class allocation_stats {
+  static constexpr std::size_t shard_count = 16;
+  static constexpr std::int64_t batch_bytes = std::int64_t{1} << 16;
+
+  struct alignas(64) shard_ {
+    std::array<std::atomic<std::uint64_t>, allocation_stats_buckets>
+        allocations{};
+    std::array<std::atomic<std::uint64_t>, allocation_stats_buckets>
+        deallocations{};
+    std::array<std::atomic<std::uint64_t>, allocation_stats_buckets>
+        allocated_bytes{};
+    std::array<std::atomic<std::uint64_t>, allocation_stats_buckets>
+        deallocated_bytes{};
+    std::array<std::atomic<std::uint64_t>, allocation_stats_buckets>
+        lifetimes{};
+    std::atomic<std::int64_t> unpublished_bytes{0};
+    std::atomic<std::uint64_t> high_water_bytes{0};
+  };
+
+  std::array<shard_, shard_count> shards_{};
+  // read by every allocation and written once per batch, so kept apart from
+  // the mark
+  alignas(64) std::atomic<std::int64_t> live_bytes_{0};
+  alignas(64) std::atomic<std::uint64_t> high_water_bytes_{0};
+
+  [[nodiscard]] static auto bucket(std::uint64_t value) noexcept
+      -> std::size_t {
+    return std::min<std::size_t>(std::bit_width(value | 1U) - 1,
+                                 allocation_stats_buckets - 1);
+  }
+
+  [[nodiscard]] auto local_shard() noexcept -> shard_ & {
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+    static constinit std::atomic<std::size_t> next_index{0};
+    thread_local const std::size_t index =
+        next_index.fetch_add(1, std::memory_order_relaxed) % shard_count;
+    return shards_[index];
+  }
+
+  static void raise_high_water(std::atomic<std::uint64_t> &mark,
+                               std::int64_t live) noexcept {
+    const auto bytes =
+        static_cast<std::uint64_t>(std::max<std::int64_t>(live, 0));
+    auto high_water = mark.load(std::memory_order_relaxed);
+
+    while (bytes > high_water and
+           not mark.compare_exchange_weak(high_water, bytes,
+                                          std::memory_order_relaxed)) {
+    }
+  }
+
+  void publish(shard_ &shard) noexcept {
+    const auto delta =
+        shard.unpublished_bytes.exchange(0, std::memory_order_relaxed);
+    const auto live =
+        live_bytes_.fetch_add(delta, std::memory_order_relaxed) + delta;
+    raise_high_water(high_water_bytes_, live);
+  }
+
+public:
+  allocation_stats() = default;
+
+  allocation_stats(const allocation_stats &) = delete;
+  allocation_stats(allocation_stats &&) = delete;
+
+  auto operator=(const allocation_stats &) -> allocation_stats & = delete;
+  auto operator=(allocation_stats &&) -> allocation_stats & = delete;
+
+  ~allocation_stats() = default;
+
+  void record_allocate(std::size_t bytes) noexcept {
+    auto &shard = local_shard();
+    const auto index = bucket(bytes);
+    const auto signed_bytes = static_cast<std::int64_t>(bytes);
+
+    shard.allocations[index].fetch_add(1, std::memory_order_relaxed);
+    shard.allocated_bytes[index].fetch_add(bytes, std::memory_order_relaxed);
+
+    const auto unpublished = shard.unpublished_bytes.fetch_add(
+                                 signed_bytes, std::memory_order_relaxed) +
+                             signed_bytes;
+
+    if (unpublished >= batch_bytes) {
+      publish(shard);
+    } else {
+      raise_high_water(shard.high_water_bytes,
+                       live_bytes_.load(std::memory_order_relaxed) +
+                           unpublished);
+    }
+  }
+
+  void record_deallocate(std::size_t bytes,
+                         std::chrono::nanoseconds lifetime) noexcept {
+    auto &shard = local_shard();
+    const auto index = bucket(bytes);
+    const auto signed_bytes = static_cast<std::int64_t>(bytes);
+    const auto ns = static_cast<std::uint64_t>(
+        std::max<std::chrono::nanoseconds::rep>(lifetime.count(), 0));
+
+    shard.deallocations[index].fetch_add(1, std::memory_order_relaxed);
+    shard.deallocated_bytes[index].fetch_add(bytes,
+                                             std::memory_order_relaxed);
+    shard.lifetimes[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+
+    // releasing memory never raises the high-water mark
+    if (shard.unpublished_bytes.fetch_sub(signed_bytes,
+                                          std::memory_order_relaxed) -
+            signed_bytes <=
+        -batch_bytes) {
+      publish(shard);
+    }
+  }
+
+  /**
+   * Sums the shards. Concurrent updates may or may not be reflected.
+   */
+  [[nodiscard]] auto snapshot() const noexcept -> allocation_stats_snapshot {
+    allocation_stats_snapshot result;
+    auto live = live_bytes_.load(std::memory_order_relaxed);
+
+    for (const auto &shard : shards_) {
+      for (std::size_t index = 0; index < allocation_stats_buckets; ++index) {
+        auto &size = result.size_classes[index];
+        size.allocations +=
+            shard.allocations[index].load(std::memory_order_relaxed);
+        size.deallocations +=
+            shard.deallocations[index].load(std::memory_order_relaxed);
+        size.allocated_bytes +=
+            shard.allocated_bytes[index].load(std::memory_order_relaxed);
+        size.deallocated_bytes +=
+            shard.deallocated_bytes[index].load(std::memory_order_relaxed);
+        result.lifetimes[index] +=
+            shard.lifetimes[index].load(std::memory_order_relaxed);
+      }
+
+      live += shard.unpublished_bytes.load(std::memory_order_relaxed);
+      result.high_water_bytes =
+          std::max(result.high_water_bytes,
+                   shard.high_water_bytes.load(std::memory_order_relaxed));
+    }
+
+    for (const auto &size : result.size_classes) {
+      result.allocations += size.allocations;
+      result.deallocations += size.deallocations;
+      result.allocated_bytes += size.allocated_bytes;
+      result.deallocated_bytes += size.deallocated_bytes;
+    }
+
+    result.live_bytes =
+        static_cast<std::uint64_t>(std::max<std::int64_t>(live, 0));
+    result.high_water_bytes =
+        std::max({result.high_water_bytes,
+                  high_water_bytes_.load(std::memory_order_relaxed),
+                  result.live_bytes});
+    return result;
+  }
+};
+
+/**
+ * An allocator adaptor which reports every allocation and deallocation to a
+ * `pr::allocation_stats`. When default-constructed, it reports to
+ * `pr::get_context<pr::allocation_stats>()`, and to nothing if that is
+ * `nullptr`. To record block lifetimes, each block is prefixed by a header of
+ * `max(alignof(value_type), 8)` bytes holding its allocation time, so
+ * `Allocator` must use raw pointers; wrap this adaptor in
+ * `pr::fancy_allocator_adaptor` to use fancy pointers.
+ */
+template <class Allocator>
+  requires std::is_pointer_v<
+      typename std::allocator_traits<Allocator>::pointer>
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+class stats_allocator_adaptor : public Allocator {
+  template <class Alloc>
+    requires std::is_pointer_v<typename std::allocator_traits<Alloc>::pointer>
+  friend class stats_allocator_adaptor;
+
+  using alloc_traits = std::allocator_traits<Allocator>;
+  using clock = std::chrono::steady_clock;
+
+  static constexpr std::size_t unit_align =
+      std::max(alignof(typename alloc_traits::value_type),
+               alignof(clock::rep));
+
+  struct alignas(unit_align) unit_ {
+    std::array<std::byte, unit_align> bytes;
+  };
+
+  using unit_alloc = alloc_traits::template rebind_alloc<unit_>;
+  using unit_traits = std::allocator_traits<unit_alloc>;
+
+  allocation_stats *stats_ = get_context<allocation_stats>();
+
+  constexpr stats_allocator_adaptor(allocation_stats *stats,
+                                    Allocator &&other) noexcept
+      : Allocator(std::move(other)), stats_(stats) {}
+
+  [[nodiscard]] static constexpr auto units_for(std::size_t n) noexcept
+      -> std::size_t {
+    const auto bytes = n * sizeof(typename alloc_traits::value_type);
+    return 1 + ((bytes + sizeof(unit_) - 1) / sizeof(unit_));
+  }
+
+public:
+  using value_type = alloc_traits::value_type;
+  using size_type = alloc_traits::size_type;
+  using difference_type = alloc_traits::difference_type;
+  using propagate_on_container_copy_assignment =
+      alloc_traits::propagate_on_container_copy_assignment;
+  using propagate_on_container_move_assignment =
+      alloc_traits::propagate_on_container_move_assignment;
+  using propagate_on_container_swap =
+      alloc_traits::propagate_on_container_swap;
+  using is_always_equal = std::false_type;
+
+  template <class U>
+  struct rebind {
+    using other = stats_allocator_adaptor<
+        typename alloc_traits::template rebind_alloc<U>>;
+  };
+
+  stats_allocator_adaptor() = default;
+
+  stats_allocator_adaptor(const stats_allocator_adaptor &other) = default;
+
+  constexpr explicit stats_allocator_adaptor(allocation_stats &stats) noexcept(
+      std::is_nothrow_default_constructible_v<Allocator>)
+      : stats_(std::addressof(stats)) {}
+
+  template <class Alloc>
+    requires std::constructible_from<Allocator, Alloc>
+  constexpr stats_allocator_adaptor(allocation_stats &stats, Alloc &&other)
+      : Allocator(std::forward<Alloc>(other)), stats_(std::addressof(stats)) {}
+
+  template <class Alloc>
+    requires std::constructible_from<Allocator, const Alloc &>
+  constexpr stats_allocator_adaptor(
+      const stats_allocator_adaptor<Alloc> &other)
+      : Allocator(static_cast<const Alloc &>(other)), stats_(other.stats_) {}
+
+  auto operator=(const stats_allocator_adaptor &other)
+      -> stats_allocator_adaptor & = default;
+
+  ~stats_allocator_adaptor() = default;
+
+  [[nodiscard]] auto stats() const noexcept -> allocation_stats * {
+    return stats_;
+  }
+
+  [[nodiscard]] auto allocate(size_type n) -> value_type * {
+    unit_alloc alloc(static_cast<const Allocator &>(*this));
+    unit_ *units = unit_traits::allocate(alloc, units_for(n));
+    clock::rep now{};
+
+    if (stats_ != nullptr) {
+      now = clock::now().time_since_epoch().count();
+      stats_->record_allocate(n * sizeof(value_type));
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    std::construct_at(reinterpret_cast<clock::rep *>(units), now);
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return reinterpret_cast<value_type *>(units + 1);
+  }
+
+  void deallocate(value_type *p, size_type n) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    unit_ *units = reinterpret_cast<unit_ *>(p) - 1;
+
+    if (stats_ != nullptr) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      const auto then = *reinterpret_cast<const clock::rep *>(units);
+      const auto now = clock::now().time_since_epoch().count();
+      stats_->record_deallocate(n * sizeof(value_type),
+                                clock::duration(now - then));
+    }
+
+    unit_alloc alloc(static_cast<const Allocator &>(*this));
+    unit_traits::deallocate(alloc, units, units_for(n));
+  }
+
+  [[nodiscard]] constexpr auto max_size() const noexcept -> size_type {
+    return (std::numeric_limits<size_type>::max() - sizeof(unit_)) /
+           sizeof(value_type);
+  }
+
+  template <class Alloc>
+  [[nodiscard]] constexpr auto
+  operator==(const stats_allocator_adaptor<Alloc> &other) const noexcept
+      -> bool {
+    return stats_ == other.stats_ and static_cast<const Allocator &>(*this) ==
+                                          static_cast<const Alloc &>(other);
+  }
+
+  [[nodiscard]] constexpr auto select_on_container_copy_construction() const
+      -> stats_allocator_adaptor {
+    return stats_allocator_adaptor(
+        stats_, alloc_traits::select_on_container_copy_construction(*this));
+  }
+};
+
+} // namespace pr
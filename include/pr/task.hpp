@@ -0,0 +1,268 @@
+#pragma once
+
+#include <pr/context.hpp>
+
+#include <coroutine>
+#include <exception>
+#include <semaphore>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace pr {
+
+template <class T = void, detail::storable_... Ts>
+  requires detail::distinct_<Ts...>
+class task;
+
+namespace detail {
+
+template <class T>
+class task_result_ {
+  std::variant<std::monostate, T, std::exception_ptr> result_;
+
+public:
+  template <class U = T>
+    requires std::constructible_from<T, U>
+  void return_value(U &&value) noexcept(
+      std::is_nothrow_constructible_v<T, U>) {
+    result_.template emplace<1>(std::forward<U>(value));
+  }
+
+  void unhandled_exception() noexcept {
+    result_.template emplace<2>(std::current_exception());
+  }
+
+  [[nodiscard]] auto result() && -> T {
+    if (result_.index() == 2) {
+      std::rethrow_exception(std::get<2>(result_));
+    }
+
+    return std::get<1>(std::move(result_));
+  }
+};
+
+template <>
+class task_result_<void> {
+  std::exception_ptr exception_;
+
+public:
+  static constexpr void return_void() noexcept {}
+
+  void unhandled_exception() noexcept {
+    exception_ = std::current_exception();
+  }
+
+  void result() && {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+  }
+};
+
+template <class A>
+[[nodiscard]] decltype(auto) get_awaiter_(A &&awaitable) {
+  if constexpr (requires { std::forward<A>(awaitable).operator co_await(); }) {
+    return std::forward<A>(awaitable).operator co_await();
+  } else if constexpr (requires {
+                         operator co_await(std::forward<A>(awaitable));
+                       }) {
+    return operator co_await(std::forward<A>(awaitable));
+  } else {
+    return std::forward<A>(awaitable);
+  }
+}
+
+/**
+ * Wraps an awaiter so that the contexts held by `contexts` are exchanged with
+ * those of the current thread immediately before suspending and immediately
+ * after resuming, so they follow the coroutine wherever it is resumed. If the
+ * awaiter is ready, the coroutine never suspends and neither exchange occurs.
+ * `Awaiter` is an lvalue reference when wrapping an lvalue awaiter.
+ */
+template <class Awaiter, storable_... Ts>
+class contextual_awaiter_ {
+  Awaiter awaiter_;
+  context_snapshot<Ts...> *contexts_;
+  bool ready_ = false;
+
+public:
+  template <class A>
+  contextual_awaiter_(A &&awaiter, context_snapshot<Ts...> &contexts)
+      : awaiter_(std::forward<A>(awaiter)), contexts_(&contexts) {}
+
+  [[nodiscard]] auto await_ready() -> bool {
+    ready_ = static_cast<bool>(awaiter_.await_ready());
+    return ready_;
+  }
+
+  template <class Promise>
+  decltype(auto) await_suspend(std::coroutine_handle<Promise> handle) {
+    contexts_->exchange();
+
+    try {
+      // `*this` may be destroyed by another thread once this call returns
+      return awaiter_.await_suspend(handle);
+    } catch (...) {
+      contexts_->exchange();
+      throw;
+    }
+  }
+
+  decltype(auto) await_resume() {
+    if (not ready_) {
+      contexts_->exchange();
+    }
+
+    return awaiter_.await_resume();
+  }
+};
+
+template <class T, storable_... Ts>
+class task_promise_ : public task_result_<T> {
+  std::coroutine_handle<> continuation_ = std::noop_coroutine();
+  std::binary_semaphore *signal_ = nullptr;
+  context_snapshot<Ts...> contexts_ = capture_context<Ts...>();
+
+  template <class, storable_... Us>
+    requires distinct_<Us...>
+  friend class pr::task;
+
+  struct final_awaiter_ {
+    [[nodiscard]] static constexpr auto await_ready() noexcept -> bool {
+      return false;
+    }
+
+    [[nodiscard]] static auto
+    await_suspend(std::coroutine_handle<task_promise_> handle) noexcept
+        -> std::coroutine_handle<> {
+      auto &promise = handle.promise();
+      promise.contexts_.exchange();
+
+      if (promise.signal_ != nullptr) {
+        promise.signal_->release();
+        return std::noop_coroutine();
+      }
+
+      return promise.continuation_;
+    }
+
+    static constexpr void await_resume() noexcept {}
+  };
+
+public:
+  [[nodiscard]] auto get_return_object() noexcept -> task<T, Ts...> {
+    return task<T, Ts...>(
+        std::coroutine_handle<task_promise_>::from_promise(*this));
+  }
+
+  [[nodiscard]] auto initial_suspend() noexcept {
+    if constexpr (sizeof...(Ts) == 0) {
+      return std::suspend_always{};
+    } else {
+      return contextual_awaiter_<std::suspend_always, Ts...>(
+          std::suspend_always{}, contexts_);
+    }
+  }
+
+  [[nodiscard]] static auto final_suspend() noexcept -> final_awaiter_ {
+    return {};
+  }
+
+  template <class A>
+  [[nodiscard]] auto await_transform(A &&awaitable) -> decltype(auto) {
+    if constexpr (sizeof...(Ts) == 0) {
+      return std::forward<A>(awaitable);
+    } else {
+      // refers to an lvalue awaiter so that its state is the caller's, and
+      // owns any other
+      using result_type = decltype(get_awaiter_(std::forward<A>(awaitable)));
+      using awaiter_type =
+          std::conditional_t<std::is_lvalue_reference_v<result_type>,
+                             result_type, std::remove_cvref_t<result_type>>;
+      return contextual_awaiter_<awaiter_type, Ts...>(
+          get_awaiter_(std::forward<A>(awaitable)), contexts_);
+    }
+  }
+};
+
+} // namespace detail
+
+/**
+ * A lazily-started coroutine producing a `T`. On creation, the coroutine
+ * captures `context_<Ts>...` of the creating thread with
+ * `pr::capture_context<Ts...>()`. Every time the coroutine resumes, the
+ * captured contexts are installed on the resuming thread, and every time it
+ * suspends, the values it displaced are reinstated. Contexts made by the
+ * coroutine itself with `pr::make_context<Ts>` are carried along the same
+ * way. Each hop costs two pointer stores per type in `Ts` in each direction.
+ */
+template <class T, detail::storable_... Ts>
+  requires detail::distinct_<Ts...>
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+class task {
+public:
+  using promise_type = detail::task_promise_<T, Ts...>;
+
+private:
+  friend promise_type;
+
+  std::coroutine_handle<promise_type> handle_;
+
+  constexpr explicit task(std::coroutine_handle<promise_type> handle) noexcept
+      : handle_(handle) {}
+
+  struct awaiter_ {
+    std::coroutine_handle<promise_type> handle;
+
+    [[nodiscard]] static constexpr auto await_ready() noexcept -> bool {
+      return false;
+    }
+
+    [[nodiscard]] auto
+    await_suspend(std::coroutine_handle<> continuation) const noexcept
+        -> std::coroutine_handle<> {
+      handle.promise().continuation_ = continuation;
+      return handle;
+    }
+
+    auto await_resume() const -> T {
+      return std::move(handle.promise()).result();
+    }
+  };
+
+public:
+  constexpr task(task &&other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)) {}
+
+  constexpr auto operator=(task &&other) noexcept -> task & {
+    std::destroy_at(this);
+    std::construct_at(this, std::move(other));
+    return *this;
+  }
+
+  constexpr ~task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  [[nodiscard]] auto operator co_await() && noexcept -> awaiter_ {
+    return awaiter_{handle_};
+  }
+
+  /**
+   * Resumes the coroutine on the calling thread and blocks until it
+   * completes, possibly on another thread, then returns its result or
+   * rethrows its exception.
+   */
+  auto sync_wait() && -> T {
+    std::binary_semaphore signal{0};
+    handle_.promise().signal_ = &signal;
+    handle_.resume();
+    signal.acquire();
+    return std::move(handle_.promise()).result();
+  }
+};
+
+} // namespace pr
@@ -0,0 +1,536 @@
+#pragma once
+
+#include <pr/context.hpp>
+#include <pr/file.hpp>
+
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) or defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace pr {
+namespace detail {
+
+struct trace_event_ {
+  const char *name;
+  std::uint64_t begin;
+  std::uint64_t end;
+  std::uint64_t id;
+  std::uint64_t parent;
+};
+
+/**
+ * A single-producer, single-consumer ring of completed spans. The owning
+ * thread is the only producer and the flusher of the active
+ * `pr::trace_session` is the only consumer. Events pushed while the ring is
+ * full are counted and dropped.
+ */
+class trace_ring_ {
+  static constexpr std::size_t capacity = std::size_t{1} << 12;
+
+  std::array<trace_event_, capacity> events_{};
+  alignas(64) std::atomic<std::size_t> head_{0};
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+  std::uint64_t next_id_;
+  pid_t tid_ = gettid();
+
+public:
+  explicit trace_ring_(std::uint64_t index) noexcept
+      : next_id_((index << 40U) + 1) {}
+
+  [[nodiscard]] auto tid() const noexcept -> pid_t { return tid_; }
+
+  [[nodiscard]] auto next_id() noexcept -> std::uint64_t { return next_id_++; }
+
+  void push(const trace_event_ &event) noexcept {
+    const auto head = head_.load(std::memory_order_relaxed);
+
+    if (head - tail_.load(std::memory_order_acquire) == capacity) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    events_[head % capacity] = event;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  template <class F>
+  void drain(F &&fn) {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    const auto head = head_.load(std::memory_order_acquire);
+
+    for (auto index = tail; index != head; ++index) {
+      fn(events_[index % capacity]);
+    }
+
+    tail_.store(head, std::memory_order_release);
+  }
+
+  [[nodiscard]] auto take_dropped() noexcept -> std::uint64_t {
+    return dropped_.exchange(0, std::memory_order_relaxed);
+  }
+};
+
+struct trace_registry_ {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<trace_ring_>> rings;
+  std::uint64_t next_index = 0;
+  bool active = false;
+};
+
+[[nodiscard]] inline auto trace_registry() -> trace_registry_ & {
+  static trace_registry_ registry;
+  return registry;
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+inline constinit std::atomic<bool> trace_enabled_{false};
+
+[[nodiscard]] inline auto local_trace_ring() -> trace_ring_ & {
+  thread_local const auto ring = [] {
+    auto &registry = trace_registry();
+    const std::scoped_lock lock(registry.mutex);
+    return registry.rings.emplace_back(
+        std::make_shared<trace_ring_>(registry.next_index++));
+  }();
+
+  return *ring;
+}
+
+[[nodiscard]] inline auto steady_ns() noexcept -> std::uint64_t {
+  timespec now{};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (static_cast<std::uint64_t>(now.tv_sec) * 1'000'000'000U) +
+         static_cast<std::uint64_t>(now.tv_nsec);
+}
+
+/**
+ * Returns the time stamp counter where available, which is calibrated against
+ * `CLOCK_MONOTONIC` by the flusher, or `CLOCK_MONOTONIC` in nanoseconds
+ * otherwise.
+ */
+[[nodiscard]] inline auto trace_ticks() noexcept -> std::uint64_t {
+#if defined(__x86_64__) or defined(__i386__)
+  return __rdtsc();
+#else
+  return steady_ns();
+#endif
+}
+
+} // namespace detail
+
+/**
+ * A timed span, intended to be installed with
+ * `pr::make_context<pr::trace_span>("name")` so that spans made while it is
+ * installed, including on other threads through `pr::capture_context`, record
+ * it as their parent. `name` must have static storage duration. When no
+ * `pr::trace_session` is active, construction and destruction each cost one
+ * predictable branch.
+ */
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+class trace_span {
+  const char *name_;
+  std::uint64_t id_ = 0;
+  std::uint64_t parent_ = 0;
+  std::uint64_t begin_ = 0;
+
+  [[gnu::noinline]] void start() noexcept {
+    const auto *parent = get_context<const trace_span>();
+    id_ = detail::local_trace_ring().next_id();
+    parent_ = parent != nullptr ? parent->id_ : 0;
+    begin_ = detail::trace_ticks();
+  }
+
+  [[gnu::noinline]] void finish() const noexcept {
+    const auto end = detail::trace_ticks();
+
+    if (not detail::trace_enabled_.load(std::memory_order_relaxed)) {
+      return;
+    }
+
+    detail::local_trace_ring().push({
+        .name = name_,
+        .begin = begin_,
+        .end = end,
+        .id = id_,
+        .parent = parent_,
+    });
+  }
+
+public:
+  explicit trace_span(const char *name) noexcept : name_(name) {
+    if (detail::trace_enabled_.load(std::memory_order_relaxed)) [[unlikely]] {
+      start();
+    }
+  }
+
+  trace_span(const trace_span &) = delete;
+
+  auto operator=(const trace_span &) -> trace_span & = delete;
+
+  ~trace_span() {
+    if (id_ != 0) [[unlikely]] {
+      finish();
+    }
+  }
+
+  [[nodiscard]] auto name() const noexcept -> const char * { return name_; }
+
+  /**
+   * Returns a process-wide unique identifier of this span, or `0` if it was
+   * constructed while no `pr::trace_session` was active.
+   */
+  [[nodiscard]] auto id() const noexcept -> std::uint64_t { return id_; }
+
+  [[nodiscard]] auto parent_id() const noexcept -> std::uint64_t {
+    return parent_;
+  }
+};
+
+enum class trace_format {
+  /**
+   * A JSON array of Chrome trace event format complete events, loadable by
+   * `chrome://tracing` and Perfetto.
+   */
+  chrome_json,
+  /**
+   * The magic `PRTRACE1` followed by native-endian records. A record starting
+   * with the byte `0` defines a name: `u32 name_index, u32 length` followed by
+   * `length` bytes. A record starting with the byte `1` is a span:
+   * `u32 name_index, u32 tid, u64 begin_ns, u64 duration_ns, u64 id,
+   * u64 parent_id`. A record starting with the byte `2` reports
+   * `u32 tid, u64 dropped_count`.
+   */
+  binary,
+};
+
+/**
+ * While alive, enables `pr::trace_span` and periodically drains the per-thread
+ * rings to `output` from a background thread. Only one session may be active
+ * at a time. Write errors stop further output and are reported by
+ * `try_stop()`.
+ */
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+class trace_session {
+  struct shared_state_ {
+    file output;
+    trace_format format;
+    std::uint64_t origin_ticks = detail::trace_ticks();
+    std::uint64_t origin_ns = detail::steady_ns();
+    double ns_per_tick = 1.0;
+    std::unordered_map<const char *, std::uint32_t> names;
+    std::string buffer;
+    bool first = true;
+    std::error_code error;
+    std::mutex mutex;
+    std::condition_variable_any wake;
+
+    shared_state_(file output, trace_format format)
+        : output(std::move(output)), format(format) {}
+
+    void calibrate() noexcept {
+#if defined(__x86_64__) or defined(__i386__)
+      const auto ticks = detail::trace_ticks() - origin_ticks;
+      const auto ns = detail::steady_ns() - origin_ns;
+
+      if (ticks != 0 and ns >= 1'000'000) {
+        ns_per_tick = static_cast<double>(ns) / static_cast<double>(ticks);
+      }
+#endif
+    }
+
+    [[nodiscard]] auto to_ns(std::uint64_t ticks) const noexcept
+        -> std::uint64_t {
+      if (ticks < origin_ticks) {
+        return 0;
+      }
+
+      return static_cast<std::uint64_t>(
+          static_cast<double>(ticks - origin_ticks) * ns_per_tick);
+    }
+
+    template <class U>
+    void append_raw(const U &value) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      buffer.append(reinterpret_cast<const char *>(std::addressof(value)),
+                    sizeof(U));
+    }
+
+    template <class U>
+    void append_number(U value) {
+      std::array<char, 32> chars{};
+      const auto [end, ec] =
+          std::to_chars(chars.data(), chars.data() + chars.size(), value);
+      buffer.append(chars.data(), end);
+    }
+
+    void append_escaped(std::string_view text) {
+      for (const auto c : text) {
+        if (c == '"' or c == '\\') {
+          buffer += '\\';
+          buffer += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+          buffer += ' ';
+        } else {
+          buffer += c;
+        }
+      }
+    }
+
+    void append_json(const detail::trace_event_ &event, pid_t pid,
+                     pid_t tid) {
+      buffer += first ? "\n" : ",\n";
+      first = false;
+      buffer += R"({"name":")";
+      append_escaped(event.name);
+      buffer += R"(","ph":"X","ts":)";
+      append_number(static_cast<double>(to_ns(event.begin)) / 1000.0);
+      buffer += R"(,"dur":)";
+      append_number(static_cast<double>(to_ns(event.end) - to_ns(event.begin)) /
+                    1000.0);
+      buffer += R"(,"pid":)";
+      append_number(pid);
+      buffer += R"(,"tid":)";
+      append_number(tid);
+      buffer += R"(,"args":{"id":)";
+      append_number(event.id);
+      buffer += R"(,"parent":)";
+      append_number(event.parent);
+      buffer += "}}";
+    }
+
+    void append_binary(const detail::trace_event_ &event, pid_t tid) {
+      const auto index = static_cast<std::uint32_t>(names.size());
+      const auto [it, inserted] = names.try_emplace(event.name, index);
+
+      if (inserted) {
+        const std::string_view name = event.name;
+        append_raw(std::uint8_t{0});
+        append_raw(it->second);
+        append_raw(static_cast<std::uint32_t>(name.size()));
+        buffer += name;
+      }
+
+      append_raw(std::uint8_t{1});
+      append_raw(it->second);
+      append_raw(static_cast<std::uint32_t>(tid));
+      append_raw(to_ns(event.begin));
+      append_raw(to_ns(event.end) - to_ns(event.begin));
+      append_raw(event.id);
+      append_raw(event.parent);
+    }
+
+    void append_dropped(pid_t tid, std::uint64_t dropped) {
+      if (format == trace_format::binary) {
+        append_raw(std::uint8_t{2});
+        append_raw(static_cast<std::uint32_t>(tid));
+        append_raw(dropped);
+        return;
+      }
+
+      buffer += first ? "\n" : ",\n";
+      first = false;
+      buffer += R"({"name":"dropped","ph":"C","ts":)";
+      append_number(static_cast<double>(detail::steady_ns() - origin_ns) /
+                    1000.0);
+      buffer += R"(,"pid":)";
+      append_number(getpid());
+      buffer += R"(,"tid":)";
+      append_number(tid);
+      buffer += R"(,"args":{"spans":)";
+      append_number(dropped);
+      buffer += "}}";
+    }
+
+    void flush() {
+      const auto bytes = std::as_bytes(std::span(buffer));
+
+      if (not error) {
+        if (auto written = output.try_write_all(bytes); not written) {
+          error = written.error();
+        }
+      }
+
+      buffer.clear();
+    }
+
+    template <class F>
+    static void for_each_ring(F &&fn) {
+      auto &registry = detail::trace_registry();
+      std::vector<std::shared_ptr<detail::trace_ring_>> rings;
+
+      {
+        const std::scoped_lock lock(registry.mutex);
+        // rings of exited threads are owned only by the registry
+        std::erase_if(registry.rings, [&](const auto &ring) {
+          if (ring.use_count() == 1) {
+            fn(*ring);
+            return true;
+          }
+
+          return false;
+        });
+        rings = registry.rings;
+      }
+
+      for (const auto &ring : rings) {
+        fn(*ring);
+      }
+    }
+
+    void drain() {
+      calibrate();
+      const auto pid = getpid();
+
+      for_each_ring([&](detail::trace_ring_ &ring) {
+        const auto tid = ring.tid();
+
+        ring.drain([&](const detail::trace_event_ &event) {
+          if (format == trace_format::binary) {
+            append_binary(event, tid);
+          } else {
+            append_json(event, pid, tid);
+          }
+        });
+
+        if (const auto dropped = ring.take_dropped(); dropped != 0) {
+          append_dropped(tid, dropped);
+        }
+      });
+
+      flush();
+    }
+
+    void discard() {
+      for_each_ring([](detail::trace_ring_ &ring) {
+        ring.drain([](const detail::trace_event_ &) {});
+        static_cast<void>(ring.take_dropped());
+      });
+    }
+  };
+
+  std::unique_ptr<shared_state_> state_;
+  std::jthread flusher_;
+
+  explicit trace_session(std::unique_ptr<shared_state_> state,
+                         std::chrono::milliseconds interval)
+      : state_(std::move(state)),
+        flusher_([state = state_.get(), interval](std::stop_token token) {
+          while (true) {
+            {
+              std::unique_lock lock(state->mutex);
+
+              if (state->wake.wait_for(lock, token, interval,
+                                       [] { return false; }) or
+                  token.stop_requested()) {
+                return;
+              }
+            }
+
+            state->drain();
+          }
+        }) {}
+
+public:
+  trace_session(trace_session &&other) noexcept = default;
+
+  auto operator=(trace_session &&other) noexcept -> trace_session & {
+    std::destroy_at(this);
+    std::construct_at(this, std::move(other));
+    return *this;
+  }
+
+  ~trace_session() { static_cast<void>(try_stop()); }
+
+  /**
+   * Disables `pr::trace_span`, joins the flusher, writes the spans still in
+   * the rings and the closing bracket of the output, then ends the session.
+   * Returns the first error encountered while writing to the output. Stopping
+   * a session that was already stopped or moved from does nothing.
+   */
+  [[nodiscard]] auto try_stop() -> std::expected<void, std::error_code> {
+    if (not state_) {
+      return {};
+    }
+
+    detail::trace_enabled_.store(false, std::memory_order_relaxed);
+    flusher_.request_stop();
+
+    if (flusher_.joinable()) {
+      flusher_.join();
+    }
+
+    const auto state = std::move(state_);
+    state->drain();
+
+    if (state->format == trace_format::chrome_json) {
+      state->buffer += "\n]\n";
+      state->flush();
+    }
+
+    {
+      auto &registry = detail::trace_registry();
+      const std::scoped_lock lock(registry.mutex);
+      registry.active = false;
+    }
+
+    if (state->error) {
+      return std::unexpected(state->error);
+    }
+
+    return {};
+  }
+
+  [[nodiscard]] static auto
+  try_start(file output, trace_format format = trace_format::chrome_json,
+            std::chrono::milliseconds interval = std::chrono::milliseconds(50))
+      -> std::expected<trace_session, std::error_code> {
+    {
+      auto &registry = detail::trace_registry();
+      const std::scoped_lock lock(registry.mutex);
+
+      if (registry.active) {
+        return std::unexpected(
+            std::make_error_code(std::errc::device_or_resource_busy));
+      }
+
+      registry.active = true;
+    }
+
+    auto state = std::make_unique<shared_state_>(std::move(output), format);
+    state->discard();
+    state->buffer = format == trace_format::binary ? "PRTRACE1" : "[";
+    state->flush();
+
+    if (state->error) {
+      auto &registry = detail::trace_registry();
+      const std::scoped_lock lock(registry.mutex);
+      registry.active = false;
+      return std::unexpected(state->error);
+    }
+
+    detail::trace_enabled_.store(true, std::memory_order_relaxed);
+    return trace_session(std::move(state), interval);
+  }
+};
+
+} // namespace pr
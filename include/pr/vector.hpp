@@ -0,0 +1,345 @@
+#pragma once
+
+#include <pr/fancy_allocator_adaptor.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace pr {
+
+/**
+ * A contiguous sequence container which, before reallocating, first asks its
+ * allocator to grow the current storage in place with `pr::try_expand`, and
+ * which obtains storage with `pr::allocate_at_least` so that any slack the
+ * allocator reports becomes usable capacity. Supports fancy pointers.
+ */
+template <class T, class Allocator = std::allocator<T>>
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
+class vector {
+  using alloc_traits = std::allocator_traits<Allocator>;
+
+public:
+  using value_type = T;
+  using allocator_type = Allocator;
+  using size_type = alloc_traits::size_type;
+  using difference_type = alloc_traits::difference_type;
+  using reference = T &;
+  using const_reference = const T &;
+  using pointer = alloc_traits::pointer;
+  using const_pointer = alloc_traits::const_pointer;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+private:
+  [[no_unique_address]] Allocator alloc_;
+  pointer data_ = nullptr;
+  size_type size_ = 0;
+  size_type capacity_ = 0;
+
+  [[nodiscard]] auto raw() const noexcept -> T * {
+    return std::to_address(data_);
+  }
+
+  void destroy_elements() noexcept {
+    for (auto *it = raw(), *last = raw() + size_; it != last; ++it) {
+      alloc_traits::destroy(alloc_, it);
+    }
+
+    size_ = 0;
+  }
+
+  void release() noexcept {
+    destroy_elements();
+
+    if (data_) {
+      alloc_traits::deallocate(alloc_, data_, capacity_);
+      data_ = nullptr;
+      capacity_ = 0;
+    }
+  }
+
+  [[nodiscard]] auto next_capacity(size_type required) const -> size_type {
+    if (required > max_size()) {
+      throw std::length_error("pr::vector");
+    }
+
+    const auto doubled =
+        capacity_ > max_size() / 2 ? max_size() : capacity_ * 2;
+    return std::max(required, doubled);
+  }
+
+  /**
+   * Attempts to grow the capacity to at least `required` without moving any
+   * element, first to the geometric capacity and then to `required` exactly.
+   */
+  [[nodiscard]] auto try_grow_in_place(size_type required) -> bool {
+    if (not data_) {
+      return false;
+    }
+
+    const auto target = next_capacity(required);
+
+    for (const auto candidate : {target, required}) {
+      if (pr::try_expand(alloc_, data_, capacity_, candidate)) {
+        capacity_ = candidate;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+   * Moves the elements into new storage of at least `required` elements. If
+   * `Emplace` is set, an element is first constructed at index `size_` from
+   * `args`, which may refer to the elements being moved.
+   */
+  template <bool Emplace, class... Args>
+  void reallocate(size_type required, Args &&...args) {
+    auto [ptr, count] = pr::allocate_at_least(alloc_, next_capacity(required));
+    auto *storage = std::to_address(ptr);
+
+    try {
+      if constexpr (Emplace) {
+        alloc_traits::construct(alloc_, storage + size_,
+                                std::forward<Args>(args)...);
+      }
+    } catch (...) {
+      alloc_traits::deallocate(alloc_, ptr, count);
+      throw;
+    }
+
+    size_type moved = 0;
+
+    try {
+      for (; moved < size_; ++moved) {
+        alloc_traits::construct(alloc_, storage + moved,
+                                std::move_if_noexcept(raw()[moved]));
+      }
+    } catch (...) {
+      for (size_type index = 0; index < moved; ++index) {
+        alloc_traits::destroy(alloc_, storage + index);
+      }
+
+      if constexpr (Emplace) {
+        alloc_traits::destroy(alloc_, storage + size_);
+      }
+
+      alloc_traits::deallocate(alloc_, ptr, count);
+      throw;
+    }
+
+    const auto size = size_;
+    release();
+    data_ = std::move(ptr);
+    capacity_ = count;
+    size_ = size;
+  }
+
+  void swap_storage(vector &other) noexcept {
+    using std::swap;
+    swap(data_, other.data_);
+    swap(size_, other.size_);
+    swap(capacity_, other.capacity_);
+  }
+
+  void steal_storage(vector &other) noexcept {
+    release();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    capacity_ = std::exchange(other.capacity_, 0);
+  }
+
+public:
+  vector() noexcept(std::is_nothrow_default_constructible_v<Allocator>)
+    requires std::default_initializable<Allocator>
+  = default;
+
+  constexpr explicit vector(const Allocator &alloc) noexcept : alloc_(alloc) {}
+
+  vector(std::initializer_list<T> values, const Allocator &alloc = Allocator())
+      : alloc_(alloc) {
+    reserve(values.size());
+
+    for (const auto &value : values) {
+      emplace_back(value);
+    }
+  }
+
+  vector(const vector &other)
+      : vector(other, alloc_traits::select_on_container_copy_construction(
+                          other.alloc_)) {}
+
+  vector(const vector &other, const Allocator &alloc) : alloc_(alloc) {
+    reserve(other.size_);
+
+    for (const auto &value : other) {
+      emplace_back(value);
+    }
+  }
+
+  vector(vector &&other) noexcept
+      : alloc_(std::move(other.alloc_)),
+        data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        capacity_(std::exchange(other.capacity_, 0)) {}
+
+  /**
+   * Replaces the elements with copies of those of `other`, taking its
+   * allocator only if `propagate_on_container_copy_assignment` is set.
+   */
+  auto operator=(const vector &other) -> vector & {
+    if (this == std::addressof(other)) {
+      return *this;
+    }
+
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+      vector copy(other, other.alloc_);
+      swap_storage(copy);
+      // `copy` frees the old storage with the old allocator
+      std::swap(alloc_, copy.alloc_);
+    } else {
+      vector copy(other, alloc_);
+      swap_storage(copy);
+    }
+
+    return *this;
+  }
+
+  /**
+   * Takes the storage of `other` if `propagate_on_container_move_assignment`
+   * is set or the allocators compare equal, and otherwise moves its elements
+   * one by one into storage from this vector's allocator.
+   */
+  auto operator=(vector &&other) noexcept(
+      alloc_traits::propagate_on_container_move_assignment::value or
+      alloc_traits::is_always_equal::value) -> vector & {
+    if (this == std::addressof(other)) {
+      return *this;
+    }
+
+    if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+      steal_storage(other);
+      alloc_ = std::move(other.alloc_);
+    } else if (alloc_traits::is_always_equal::value or alloc_ == other.alloc_) {
+      steal_storage(other);
+    } else {
+      vector moved(alloc_);
+      moved.reserve(other.size_);
+
+      for (auto &value : other) {
+        moved.emplace_back(std::move(value));
+      }
+
+      swap_storage(moved);
+    }
+
+    return *this;
+  }
+
+  ~vector() { release(); }
+
+  /**
+   * Exchanges the elements of the two vectors, and their allocators only if
+   * `propagate_on_container_swap` is set; otherwise the allocators must
+   * compare equal.
+   */
+  void swap(vector &other) noexcept {
+    if constexpr (alloc_traits::propagate_on_container_swap::value) {
+      using std::swap;
+      swap(alloc_, other.alloc_);
+    }
+
+    swap_storage(other);
+  }
+
+  friend void swap(vector &x, vector &y) noexcept { x.swap(y); }
+
+  [[nodiscard]] auto get_allocator() const noexcept -> allocator_type {
+    return alloc_;
+  }
+
+  [[nodiscard]] auto data() noexcept -> T * { return raw(); }
+  [[nodiscard]] auto data() const noexcept -> const T * { return raw(); }
+
+  [[nodiscard]] auto begin() noexcept -> iterator { return raw(); }
+  [[nodiscard]] auto begin() const noexcept -> const_iterator { return raw(); }
+
+  [[nodiscard]] auto end() noexcept -> iterator { return raw() + size_; }
+  [[nodiscard]] auto end() const noexcept -> const_iterator {
+    return raw() + size_;
+  }
+
+  [[nodiscard]] auto size() const noexcept -> size_type { return size_; }
+
+  [[nodiscard]] auto capacity() const noexcept -> size_type {
+    return capacity_;
+  }
+
+  [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+
+  [[nodiscard]] auto max_size() const noexcept -> size_type {
+    return alloc_traits::max_size(alloc_);
+  }
+
+  [[nodiscard]] auto operator[](size_type index) noexcept -> reference {
+    return raw()[index];
+  }
+
+  [[nodiscard]] auto operator[](size_type index) const noexcept
+      -> const_reference {
+    return raw()[index];
+  }
+
+  [[nodiscard]] auto front() noexcept -> reference { return raw()[0]; }
+  [[nodiscard]] auto back() noexcept -> reference { return raw()[size_ - 1]; }
+
+  void reserve(size_type required) {
+    if (required <= capacity_ or try_grow_in_place(required)) {
+      return;
+    }
+
+    reallocate<false>(required);
+  }
+
+  template <class... Args>
+  auto emplace_back(Args &&...args) -> reference {
+    if (size_ == capacity_ and not try_grow_in_place(size_ + 1)) {
+      reallocate<true>(size_ + 1, std::forward<Args>(args)...);
+    } else {
+      alloc_traits::construct(alloc_, raw() + size_,
+                              std::forward<Args>(args)...);
+    }
+
+    return raw()[size_++];
+  }
+
+  void push_back(const T &value) { emplace_back(value); }
+
+  void push_back(T &&value) { emplace_back(std::move(value)); }
+
+  void pop_back() noexcept {
+    alloc_traits::destroy(alloc_, raw() + --size_);
+  }
+
+  void resize(size_type count) {
+    while (size_ > count) {
+      pop_back();
+    }
+
+    reserve(count);
+
+    while (size_ < count) {
+      emplace_back();
+    }
+  }
+
+  void clear() noexcept { destroy_elements(); }
+};
+
+} // namespace pr
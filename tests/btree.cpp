@@ -0,0 +1,107 @@
+#include "check.hpp"
+
+#include <pr/arena.hpp>
+#include <pr/btree.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <new>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using tree = pr::btree<std::int64_t, double>;
+
+/**
+ * Checks that `t` holds exactly the entries of `expected`, both when iterated
+ * and when searched.
+ */
+void check_entries(const tree &t,
+                   const std::map<std::int64_t, double> &expected) {
+  CHECK(t.size() == expected.size());
+
+  auto it = expected.begin();
+
+  for (const auto &[key, value] : t) {
+    CHECK(it != expected.end() and it->first == key and it->second == value);
+    ++it;
+  }
+
+  CHECK(it == expected.end());
+
+  for (const auto &[key, value] : expected) {
+    CHECK(t.contains(key));
+  }
+}
+
+/**
+ * Inserts keys from `next_key` into a tree confined to a small arena until
+ * allocation has failed `failures` times, checking that each failure leaves
+ * the tree unchanged.
+ */
+template <class F>
+void insert_until_exhausted(F next_key, int failures) {
+  alignas(tree::cache_line) std::array<std::byte, 4608> region{};
+  pr::arena arena(region);
+  tree t{pr::arena_allocator<std::byte>(arena)};
+  std::map<std::int64_t, double> expected;
+
+  while (failures > 0) {
+    const auto key = next_key();
+
+    try {
+      const auto [it, inserted] = t.insert(key, 0.5);
+      CHECK(it.key() == key);
+      expected.emplace(key, 0.5);
+    } catch (const std::bad_alloc &) {
+      --failures;
+    }
+
+    check_entries(t, expected);
+  }
+}
+
+void bulk_load_exhausted() {
+  alignas(tree::cache_line) std::array<std::byte, 4608> region{};
+  pr::arena arena(region);
+  tree t{pr::arena_allocator<std::byte>(arena)};
+  std::vector<std::pair<std::int64_t, double>> entries;
+
+  for (std::int64_t key = 0; key < 4096; ++key) {
+    entries.emplace_back(key, 0.5);
+  }
+
+  bool threw = false;
+
+  try {
+    t.bulk_load(entries);
+  } catch (const std::bad_alloc &) {
+    threw = true;
+  }
+
+  CHECK(threw);
+  CHECK(t.empty() and t.begin() == t.end() and not t.contains(0));
+  CHECK(arena.used() == 0);
+
+  entries.resize(64);
+  t.bulk_load(entries);
+  check_entries(t, {entries.begin(), entries.end()});
+}
+
+} // namespace
+
+auto main() -> int {
+  std::mt19937_64 random(42);
+  insert_until_exhausted(
+      [&] { return static_cast<std::int64_t>(random() % 100000); }, 64);
+
+  std::int64_t ascending = 0;
+  insert_until_exhausted([&] { return ascending++; }, 8);
+
+  bulk_load_exhausted();
+  return pr::test::exit_status();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace pr::test {
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+inline int failures = 0;
+
+inline void check(bool condition, const char *expression, const char *file,
+                  int line) {
+  if (not condition) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    ++failures;
+  }
+}
+
+[[nodiscard]] inline auto exit_status() -> int {
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace pr::test
+
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define CHECK(...)                                                             \
+  ::pr::test::check(static_cast<bool>(__VA_ARGS__), #__VA_ARGS__, __FILE__,    \
+                    __LINE__)
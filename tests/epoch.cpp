@@ -0,0 +1,219 @@
+#include "check.hpp"
+
+#include <pr/epoch.hpp>
+#include <pr/mapping.hpp>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * A node which is marked instead of freed when reclaimed, so that readers can
+ * detect reclamation while they still hold it without a use after free.
+ */
+struct item : pr::epoch_node {
+  std::uint64_t value = 0;
+  std::atomic<bool> reclaimed{false};
+};
+
+void readers_and_writers() {
+  constexpr std::size_t reader_count = 4;
+  constexpr std::size_t writer_count = 2;
+  constexpr std::uint64_t writes = 20000;
+
+  pr::epoch_domain<16> domain;
+  std::atomic<item *> head{new item{}};
+  std::atomic<bool> stopping{false};
+  std::atomic<std::uint64_t> stale_reads{0};
+  std::vector<std::jthread> readers;
+  std::vector<std::jthread> writers;
+  std::array<std::vector<item *>, writer_count> graveyards;
+
+  for (std::size_t index = 0; index < reader_count; ++index) {
+    readers.emplace_back([&] {
+      auto participant = domain.try_register();
+      CHECK(participant.has_value());
+
+      while (not stopping.load(std::memory_order_relaxed)) {
+        const auto guard = participant->enter();
+        const auto *current = head.load(std::memory_order_acquire);
+
+        if (current->reclaimed.load(std::memory_order_relaxed)) {
+          stale_reads.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+  }
+
+  for (auto &graveyard : graveyards) {
+    writers.emplace_back([&] {
+      auto participant = domain.try_register();
+      CHECK(participant.has_value());
+
+      const auto reclaim = [&](pr::epoch_node &node) {
+        auto &reclaimed = static_cast<item &>(node);
+        reclaimed.reclaimed.store(true, std::memory_order_relaxed);
+        graveyard.push_back(&reclaimed);
+      };
+
+      for (std::uint64_t write = 1; write <= writes; ++write) {
+        auto *next = new item{};
+        next->value = write;
+        // an in-place update: unlink the old node, then retire it
+        participant->retire(*head.exchange(next, std::memory_order_acq_rel));
+
+        if (write % 64 == 0) {
+          participant->collect(reclaim);
+        }
+      }
+
+      stopping.store(true, std::memory_order_relaxed);
+
+      // with no reader left inside a critical section, the epoch advances on
+      // every attempt, and everything retired becomes reclaimable
+      while (graveyard.size() < writes) {
+        participant->collect(reclaim);
+        std::this_thread::yield();
+      }
+    });
+  }
+
+  writers.clear();
+  readers.clear();
+
+  CHECK(stale_reads.load() == 0);
+
+  for (const auto &graveyard : graveyards) {
+    CHECK(graveyard.size() == writes);
+
+    for (auto *node : graveyard) {
+      delete node;
+    }
+  }
+
+  delete head.load();
+}
+
+/**
+ * A domain and the nodes retired to it, shared with forked children.
+ */
+struct segment {
+  pr::epoch_domain<3> domain{2};
+  std::array<item, 3> nodes;
+};
+
+[[nodiscard]] auto make_segment() -> std::pair<pr::mapping, segment *> {
+  auto region = pr::mapping::try_mmap(
+      nullptr, sizeof(segment),
+      {.prot = PROT_READ | PROT_WRITE, .flags = MAP_ANONYMOUS | MAP_SHARED});
+  auto *shared = std::construct_at(
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      reinterpret_cast<segment *>(region->data()));
+  return {std::move(*region), shared};
+}
+
+/**
+ * Runs `fn` in a child process, which `fn` ends with `_exit` to die without
+ * unregistering its participants.
+ */
+template <class F>
+void in_child(F fn) {
+  const auto pid = fork();
+
+  if (pid == 0) {
+    fn();
+    // `fn` returned, so its participants unregistered
+    _exit(1);
+  }
+
+  int status = 0;
+  CHECK(waitpid(pid, &status, 0) == pid);
+  CHECK(WIFEXITED(status) and WEXITSTATUS(status) == 0);
+}
+
+/**
+ * A child dies outside of any critical section, so it never stalls the epoch,
+ * and its slots are recovered when registering.
+ */
+void evict_inactive() {
+  auto [region, shared] = make_segment();
+
+  in_child([shared = shared] {
+    auto first = shared->domain.try_register();
+    auto second = shared->domain.try_register();
+    first->retire(shared->nodes[0]);
+    second->retire(shared->nodes[1]);
+    // dies without unregistering
+    _exit(0);
+  });
+
+  // takes over the first slot and evicts the second
+  auto participant = shared->domain.try_register();
+  CHECK(participant.has_value() and participant->slot_index() == 0);
+
+  std::size_t reclaimed = 0;
+
+  for (int attempt = 0; attempt < 4; ++attempt) {
+    reclaimed += participant->collect([&](pr::epoch_node &node) {
+      CHECK(&node == &shared->nodes[0] or &node == &shared->nodes[1]);
+    });
+  }
+
+  CHECK(reclaimed == 2);
+
+  auto second = shared->domain.try_register();
+  auto third = shared->domain.try_register();
+  CHECK(second.has_value() and third.has_value());
+  CHECK(shared->domain.try_register().error() ==
+        std::errc::resource_unavailable_try_again);
+}
+
+/**
+ * A child dies inside a critical section, which stalls the epoch until a
+ * collector evicts it.
+ */
+void evict_active() {
+  auto [region, shared] = make_segment();
+  auto participant = shared->domain.try_register();
+  CHECK(participant.has_value());
+
+  in_child([shared = shared] {
+    auto stalled = shared->domain.try_register();
+    const auto guard = stalled->enter();
+    stalled->retire(shared->nodes[2]);
+    // dies inside the critical section
+    _exit(0);
+  });
+
+  const auto epoch = shared->domain.epoch();
+  std::size_t reclaimed = 0;
+
+  for (int attempt = 0; attempt < 8; ++attempt) {
+    reclaimed += participant->collect([&](pr::epoch_node &node) {
+      CHECK(&node == &shared->nodes[2]);
+    });
+  }
+
+  CHECK(reclaimed == 1);
+  CHECK(shared->domain.epoch() >= epoch + 2);
+}
+
+} // namespace
+
+auto main() -> int {
+  evict_inactive();
+  evict_active();
+  readers_and_writers();
+  return pr::test::exit_status();
+}
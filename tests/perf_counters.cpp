@@ -0,0 +1,88 @@
+#include "check.hpp"
+
+#include <pr/perf_counters.hpp>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <utility>
+
+namespace {
+
+// the events which fall back to software counters without a PMU
+constexpr std::array software_events{pr::perf_event::cycles,
+                                     pr::perf_event::page_faults};
+
+/**
+ * Opens `software_events`, or returns `std::nullopt` where the kernel does not
+ * permit `perf_event_open` at all, e.g. under a seccomp filter.
+ */
+[[nodiscard]] auto open_software_events() -> std::optional<pr::perf_counters> {
+  auto counters = pr::perf_counters::try_open(software_events);
+
+  if (not counters) {
+    std::printf("skipped: %s\n", counters.error().message().c_str());
+    return std::nullopt;
+  }
+
+  return std::move(*counters);
+}
+
+void counts_page_faults() {
+  const auto counters = open_software_events();
+
+  if (not counters) {
+    return;
+  }
+
+  CHECK(counters->contains(pr::perf_event::cycles));
+  CHECK(counters->contains(pr::perf_event::page_faults));
+  CHECK(counters->is_software(pr::perf_event::page_faults));
+
+  constexpr std::size_t page_count = 64;
+  const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  auto region = pr::mapping::try_mmap(
+      nullptr, page_count * page_size,
+      {.prot = PROT_READ | PROT_WRITE, .flags = MAP_ANONYMOUS | MAP_PRIVATE});
+  CHECK(region.has_value());
+
+  const auto reading = counters->try_measure([&] {
+    const std::span<std::byte> bytes(*region);
+
+    // the first write to each fresh page faults it in
+    for (std::size_t offset = 0; offset < bytes.size(); offset += page_size) {
+      *static_cast<volatile std::byte *>(&bytes[offset]) = std::byte{1};
+    }
+  });
+  CHECK(reading.has_value());
+
+  const auto faults = (*reading)[pr::perf_event::page_faults];
+  CHECK(faults.has_value() and *faults >= page_count);
+  CHECK((*reading)[pr::perf_event::cycles].value_or(0) > 0);
+  CHECK(reading->time_enabled > 0);
+}
+
+void rejects_repeated_events() {
+  constexpr std::array events{
+      pr::perf_event::page_faults, pr::perf_event::page_faults,
+      pr::perf_event::page_faults, pr::perf_event::page_faults,
+      pr::perf_event::page_faults, pr::perf_event::page_faults,
+  };
+
+  CHECK(pr::perf_counters::try_open(events).error() ==
+        std::errc::invalid_argument);
+}
+
+} // namespace
+
+auto main() -> int {
+  counts_page_faults();
+  rejects_repeated_events();
+  return pr::test::exit_status();
+}
@@ -0,0 +1,84 @@
+#include "check.hpp"
+
+#include <pr/file.hpp>
+#include <pr/mapping.hpp>
+#include <pr/shared_memory.hpp>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <span>
+#include <system_error>
+#include <utility>
+
+namespace {
+
+constexpr std::size_t size = 4096;
+
+[[nodiscard]] auto make_sealed() -> pr::sealed_shared_memory {
+  auto memory = pr::shared_memory::try_create("pr_test_shared_memory", size);
+  CHECK(memory.has_value());
+  std::ranges::fill(memory->bytes(), std::byte{42});
+
+  auto sealed = std::move(*memory).try_seal();
+  CHECK(sealed.has_value());
+  return std::move(*sealed);
+}
+
+[[nodiscard]] auto holds_pattern(std::span<const std::byte> bytes) -> bool {
+  return bytes.size() == size and std::ranges::all_of(bytes, [](auto byte) {
+           return byte == std::byte{42};
+         });
+}
+
+void seals_block_changes() {
+  const auto sealed = make_sealed();
+  const auto fd = *sealed.descriptor();
+  CHECK(holds_pattern(sealed.bytes()));
+
+  const std::byte byte{0};
+  CHECK(pwrite(fd, &byte, 1, 0) == -1 and errno == EPERM);
+  CHECK(ftruncate(fd, size * 2) == -1 and errno == EPERM);
+  CHECK(ftruncate(fd, size / 2) == -1 and errno == EPERM);
+  CHECK(pr::mapping::try_mmap(nullptr, size,
+                              {
+                                  .prot = PROT_READ | PROT_WRITE,
+                                  .flags = MAP_SHARED,
+                                  .fd = fd,
+                              })
+            .error() == std::errc::operation_not_permitted);
+}
+
+void adopts_sealed_descriptors() {
+  const auto sealed = make_sealed();
+  auto duplicate = pr::file::try_adopt(dup(*sealed.descriptor()));
+  CHECK(duplicate.has_value());
+
+  const auto adopted =
+      pr::sealed_shared_memory::try_adopt(std::move(*duplicate));
+  CHECK(adopted.has_value());
+  CHECK(holds_pattern(adopted->bytes()));
+}
+
+void rejects_unsealed_descriptors() {
+  const auto memory =
+      pr::shared_memory::try_create("pr_test_shared_memory", size);
+  CHECK(memory.has_value());
+
+  auto duplicate = pr::file::try_adopt(dup(*memory->descriptor()));
+  CHECK(duplicate.has_value());
+  CHECK(pr::sealed_shared_memory::try_adopt(std::move(*duplicate)).error() ==
+        std::errc::operation_not_permitted);
+}
+
+} // namespace
+
+auto main() -> int {
+  seals_block_changes();
+  adopts_sealed_descriptors();
+  rejects_unsealed_descriptors();
+  return pr::test::exit_status();
+}
@@ -0,0 +1,176 @@
+#include "check.hpp"
+
+#include <pr/arena.hpp>
+#include <pr/file.hpp>
+#include <pr/mapping.hpp>
+#include <pr/offset_ptr.hpp>
+#include <pr/snapshot.hpp>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <system_error>
+
+namespace {
+
+struct root {
+  pr::offset_ptr<std::uint32_t> values;
+  std::uint32_t count = 0;
+};
+
+struct other_root {
+  std::uint64_t value = 0;
+};
+
+constexpr std::uint64_t schema_version = 3;
+constexpr std::uint32_t value_count = 100;
+
+/**
+ * Writes a snapshot of a root and an array of values allocated from an arena
+ * to a fresh anonymous file.
+ */
+[[nodiscard]] auto write_snapshot() -> pr::file {
+  auto output = pr::file::try_adopt(memfd_create("pr_test_snapshot", 0));
+  CHECK(output.has_value());
+
+  auto region = pr::mapping::try_mmap(nullptr, 4096);
+  CHECK(region.has_value());
+
+  pr::arena arena(*region);
+  auto *values =
+      pr::arena_allocator<std::uint32_t>(arena).allocate(value_count);
+
+  for (std::uint32_t index = 0; index < value_count; ++index) {
+    values[index] = index * index;
+  }
+
+  auto *snapshot_root =
+      std::construct_at(pr::arena_allocator<root>(arena).allocate(1));
+  snapshot_root->values = values;
+  snapshot_root->count = value_count;
+
+  CHECK(pr::try_write_snapshot(*output, arena.data(), *snapshot_root,
+                               schema_version)
+            .has_value());
+  return std::move(*output);
+}
+
+[[nodiscard]] auto read_header(const pr::file &input) -> pr::snapshot_header {
+  pr::snapshot_header header;
+  CHECK(pread(*input, &header, sizeof(header), 0) == sizeof(header));
+  return header;
+}
+
+/**
+ * Rewrites the header of the snapshot in `input` after applying `edit`,
+ * recomputing its checksum unless `edit` invalidated it on purpose.
+ */
+template <class F>
+void edit_header(const pr::file &input, F edit, bool rehash = true) {
+  auto header = read_header(input);
+  edit(header);
+
+  if (rehash) {
+    header.header_checksum = header.checksum();
+  }
+
+  CHECK(pwrite(*input, &header, sizeof(header), 0) == sizeof(header));
+}
+
+[[nodiscard]] auto load_error(const pr::file &input,
+                              std::uint64_t schema = schema_version)
+    -> std::error_code {
+  const auto loaded = pr::snapshot<root>::try_load(input, schema);
+  return loaded ? std::error_code{} : loaded.error();
+}
+
+void round_trip() {
+  const auto input = write_snapshot();
+  const auto loaded = pr::snapshot<root>::try_load(input, schema_version);
+  CHECK(loaded.has_value());
+
+  const auto &snapshot_root = loaded->root();
+  CHECK(snapshot_root.count == value_count);
+
+  for (std::uint32_t index = 0; index < value_count; ++index) {
+    CHECK(snapshot_root.values.get()[index] == index * index);
+  }
+
+  CHECK(loaded->verify_payload());
+}
+
+void rejects_corruption() {
+  {
+    const auto input = write_snapshot();
+    edit_header(input, [](auto &header) { header.magic[0] = 'X'; });
+    CHECK(load_error(input) == pr::snapshot_errc::bad_magic);
+  }
+
+  {
+    const auto input = write_snapshot();
+    edit_header(
+        input, [](auto &header) { ++header.payload_size; }, false);
+    CHECK(load_error(input) == pr::snapshot_errc::header_checksum_mismatch);
+  }
+
+  {
+    const auto input = write_snapshot();
+    CHECK(pr::snapshot<other_root>::try_load(input, schema_version).error() ==
+          pr::snapshot_errc::fingerprint_mismatch);
+  }
+
+  {
+    const auto input = write_snapshot();
+    CHECK(load_error(input, schema_version + 1) ==
+          pr::snapshot_errc::schema_mismatch);
+  }
+
+  {
+    const auto input = write_snapshot();
+    const auto header = read_header(input);
+    CHECK(ftruncate(*input, static_cast<off_t>(header.payload_offset +
+                                               header.payload_size - 1)) == 0);
+    CHECK(load_error(input) == pr::snapshot_errc::truncated);
+    CHECK(ftruncate(*input, sizeof(header) - 1) == 0);
+    CHECK(load_error(input) == pr::snapshot_errc::truncated);
+  }
+
+  {
+    const auto input = write_snapshot();
+    edit_header(input, [](auto &header) {
+      // one past the end of the payload once mapped
+      const auto end = header.payload_offset + header.payload_size -
+                       offsetof(pr::snapshot_header, root);
+      header.root = pr::offset_ptr<const std::byte>(
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
+          reinterpret_cast<const std::byte *>(
+              reinterpret_cast<std::uintptr_t>(&header.root) + end));
+    });
+    CHECK(load_error(input) == pr::snapshot_errc::out_of_bounds);
+  }
+
+  {
+    const auto input = write_snapshot();
+    const std::byte flipped{0xff};
+    const auto header = read_header(input);
+    CHECK(pwrite(*input, &flipped, 1,
+                 static_cast<off_t>(header.payload_offset)) == 1);
+
+    // the payload is only checked on demand
+    const auto loaded = pr::snapshot<root>::try_load(input, schema_version);
+    CHECK(loaded.has_value() and not loaded->verify_payload());
+  }
+}
+
+} // namespace
+
+auto main() -> int {
+  round_trip();
+  rejects_corruption();
+  return pr::test::exit_status();
+}
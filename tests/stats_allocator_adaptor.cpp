@@ -0,0 +1,59 @@
+#include "check.hpp"
+
+#include <pr/context.hpp>
+#include <pr/stats_allocator_adaptor.hpp>
+
+#include <cstddef>
+#include <memory>
+
+namespace {
+
+using allocator = pr::stats_allocator_adaptor<std::allocator<std::byte>>;
+using traits = std::allocator_traits<allocator>;
+
+/**
+ * Allocates 8620 bytes in total with at most 4524 live at once, a peak far
+ * below a shard's batch.
+ */
+void small_peak() {
+  pr::allocation_stats stats;
+  allocator alloc(stats);
+
+  auto *first = traits::allocate(alloc, 1024);
+  auto *second = traits::allocate(alloc, 3072);
+  traits::deallocate(alloc, second, 3072);
+  auto *third = traits::allocate(alloc, 2000);
+  traits::deallocate(alloc, first, 1024);
+  auto *fourth = traits::allocate(alloc, 2524);
+
+  auto snapshot = stats.snapshot();
+  CHECK(snapshot.allocated_bytes == 8620);
+  CHECK(snapshot.live_bytes == 4524);
+  CHECK(snapshot.high_water_bytes == 4524);
+
+  traits::deallocate(alloc, third, 2000);
+  traits::deallocate(alloc, fourth, 2524);
+
+  snapshot = stats.snapshot();
+  CHECK(snapshot.live_bytes == 0);
+  CHECK(snapshot.high_water_bytes == 4524);
+  CHECK(snapshot.allocations == 4 and snapshot.deallocations == 4);
+}
+
+void without_stats() {
+  CHECK(pr::get_context<pr::allocation_stats>() == nullptr);
+
+  allocator alloc;
+  CHECK(alloc.stats() == nullptr);
+
+  auto *bytes = traits::allocate(alloc, 64);
+  traits::deallocate(alloc, bytes, 64);
+}
+
+} // namespace
+
+auto main() -> int {
+  small_peak();
+  without_stats();
+  return pr::test::exit_status();
+}
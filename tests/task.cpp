@@ -0,0 +1,115 @@
+#include "check.hpp"
+
+#include <pr/context.hpp>
+#include <pr/executor.hpp>
+#include <pr/task.hpp>
+
+#include <coroutine>
+
+namespace {
+
+/**
+ * An awaiter that never suspends, so `pr::task` must neither install nor
+ * displace any contexts around it.
+ */
+struct ready_awaiter {
+  int value;
+
+  [[nodiscard]] static constexpr auto await_ready() noexcept -> bool {
+    return true;
+  }
+
+  static void await_suspend(std::coroutine_handle<> /*handle*/) noexcept {}
+
+  [[nodiscard]] constexpr auto await_resume() const noexcept -> int {
+    return value;
+  }
+};
+
+/**
+ * A stateful awaiter which cannot be copied, so `pr::task` must await the
+ * caller's object itself. It suspends and is resumed immediately.
+ */
+struct counting_awaiter {
+  bool ready = false;
+  int suspends = 0;
+  int resumes = 0;
+
+  counting_awaiter() = default;
+  counting_awaiter(const counting_awaiter &) = delete;
+  auto operator=(const counting_awaiter &) -> counting_awaiter & = delete;
+  ~counting_awaiter() = default;
+
+  [[nodiscard]] auto await_ready() const noexcept -> bool { return ready; }
+
+  [[nodiscard]] auto await_suspend(std::coroutine_handle<> /*handle*/) noexcept
+      -> bool {
+    ++suspends;
+    return false;
+  }
+
+  auto await_resume() noexcept -> int { return ++resumes; }
+};
+
+auto lvalue_awaiters(counting_awaiter &awaiter) -> pr::task<int, int> {
+  const auto inner = pr::make_context<int>(2);
+  co_await awaiter;
+  CHECK(*pr::get_context<int>() == 2);
+
+  awaiter.ready = true;
+  const auto resumes = co_await awaiter;
+  CHECK(*pr::get_context<int>() == 2);
+  co_return resumes;
+}
+
+auto ready_awaiters() -> pr::task<int, int> {
+  CHECK(*pr::get_context<int>() == 1);
+
+  const auto inner = pr::make_context<int>(2);
+  const auto first = co_await ready_awaiter{3};
+  CHECK(*pr::get_context<int>() == 2);
+
+  co_await std::suspend_never{};
+  CHECK(*pr::get_context<int>() == 2);
+  co_return first + *pr::get_context<int>();
+}
+
+auto scheduled(pr::work_stealing_executor &executor) -> pr::task<int, int> {
+  const auto inner = pr::make_context<int>(2);
+  co_await executor.schedule();
+  CHECK(*pr::get_context<int>() == 2);
+
+  co_await ready_awaiter{0};
+  CHECK(*pr::get_context<int>() == 2);
+
+  co_await executor.schedule();
+  co_return *pr::get_context<int>();
+}
+
+} // namespace
+
+auto main() -> int {
+  {
+    const auto outer = pr::make_context<int>(1);
+    CHECK(ready_awaiters().sync_wait() == 5);
+    CHECK(*pr::get_context<int>() == 1);
+  }
+
+  {
+    pr::work_stealing_executor executor(2);
+    const auto outer = pr::make_context<int>(1);
+    CHECK(scheduled(executor).sync_wait() == 2);
+    CHECK(*pr::get_context<int>() == 1);
+  }
+
+  {
+    counting_awaiter awaiter;
+    const auto outer = pr::make_context<int>(1);
+    CHECK(lvalue_awaiters(awaiter).sync_wait() == 2);
+    CHECK(awaiter.suspends == 1 and awaiter.resumes == 2);
+    CHECK(*pr::get_context<int>() == 1);
+  }
+
+  CHECK(pr::get_context<int>() == nullptr);
+  return pr::test::exit_status();
+}
@@ -0,0 +1,93 @@
+#include "check.hpp"
+
+#include <pr/context.hpp>
+#include <pr/file.hpp>
+#include <pr/trace.hpp>
+
+#include <array>
+#include <csignal>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+
+namespace {
+
+struct pipe_ {
+  pr::file read;
+  pr::file write;
+};
+
+[[nodiscard]] auto make_pipe() -> pipe_ {
+  std::array<int, 2> fds{};
+  CHECK(pipe(fds.data()) == 0);
+  return {*pr::file::try_adopt(fds[0]), *pr::file::try_adopt(fds[1])};
+}
+
+[[nodiscard]] auto read_all(const pr::file &input) -> std::string {
+  std::string result;
+  std::array<char, 4096> chunk{};
+
+  while (true) {
+    const auto count = ::read(*input, chunk.data(), chunk.size());
+
+    if (count <= 0) {
+      return result;
+    }
+
+    result.append(chunk.data(), static_cast<std::size_t>(count));
+  }
+}
+
+void stop_flushes() {
+  auto [input, output] = make_pipe();
+  auto session = pr::trace_session::try_start(std::move(output));
+  CHECK(session.has_value());
+
+  {
+    const auto span = pr::make_context<pr::trace_span>("stop_flushes");
+  }
+
+  CHECK(session->try_stop().has_value());
+  // a second stop, like the destructor's, does nothing
+  CHECK(session->try_stop().has_value());
+
+  const auto json = read_all(input);
+  CHECK(json.starts_with("[") and json.ends_with("\n]\n"));
+  CHECK(json.find(R"("name":"stop_flushes")") != std::string::npos);
+}
+
+void stop_reports_errors() {
+  auto [input, output] = make_pipe();
+  auto started = pr::trace_session::try_start(std::move(output));
+  CHECK(started.has_value());
+
+  // moving the session must not hide the error from the new owner
+  auto session = std::move(*started);
+  CHECK(started->try_stop().has_value());
+
+  {
+    // closing the read end makes the final flush fail
+    const auto closed = std::move(input);
+  }
+
+  const auto stopped = session.try_stop();
+  CHECK(not stopped and
+        stopped.error() == std::make_error_code(std::errc::broken_pipe));
+
+  // the failed session still ended, so another may start
+  auto [next_input, next_output] = make_pipe();
+  auto next = pr::trace_session::try_start(std::move(next_output));
+  CHECK(next.has_value() and next->try_stop().has_value());
+}
+
+} // namespace
+
+auto main() -> int {
+  // NOLINTNEXTLINE(cert-err33-c)
+  std::signal(SIGPIPE, SIG_IGN);
+
+  stop_flushes();
+  stop_reports_errors();
+  return pr::test::exit_status();
+}
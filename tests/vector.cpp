@@ -0,0 +1,143 @@
+#include "check.hpp"
+
+#include <pr/arena.hpp>
+#include <pr/fancy_allocator_adaptor.hpp>
+#include <pr/offset_ptr.hpp>
+#include <pr/vector.hpp>
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace {
+
+using fancy_allocator =
+    pr::fancy_allocator_adaptor<pr::arena_allocator<int>, pr::offset_ptr<int>>;
+
+template <class Allocator>
+using vector = pr::vector<int, Allocator>;
+
+/**
+ * A region for an arena, aligned for every element type used below.
+ */
+struct region {
+  alignas(pr::arena::granularity) std::array<std::byte, 4096> bytes{};
+
+  [[nodiscard]] auto contains(const void *p) const noexcept -> bool {
+    const auto *byte = static_cast<const std::byte *>(p);
+    return bytes.data() <= byte and byte < bytes.data() + bytes.size();
+  }
+};
+
+void fill(auto &values, int count) {
+  for (int value = 0; value < count; ++value) {
+    values.push_back(value);
+  }
+}
+
+[[nodiscard]] auto holds_sequence(const auto &values, int count) -> bool {
+  if (values.size() != static_cast<std::size_t>(count)) {
+    return false;
+  }
+
+  for (int value = 0; value < count; ++value) {
+    if (values[static_cast<std::size_t>(value)] != value) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void slack_becomes_capacity() {
+  region memory;
+  pr::arena arena(memory.bytes);
+  pr::vector<char, pr::arena_allocator<char>> values{
+      pr::arena_allocator<char>(arena)};
+
+  values.reserve(1);
+  // the arena rounds every allocation up to its granularity
+  CHECK(values.capacity() == pr::arena::granularity);
+}
+
+void grows_in_place() {
+  region memory;
+  pr::arena arena(memory.bytes);
+  vector<fancy_allocator> values{fancy_allocator(arena)};
+
+  values.push_back(0);
+  const auto *data = values.data();
+  fill(values, 256);
+
+  // the buffer is the arena's most recent allocation, so it is extended
+  CHECK(values.data() == data);
+  CHECK(values.capacity() >= 256);
+  CHECK(arena.used() == values.capacity() * sizeof(int));
+  values.clear();
+  fill(values, 256);
+  CHECK(holds_sequence(values, 256));
+}
+
+void reallocates_when_blocked() {
+  region memory;
+  pr::arena arena(memory.bytes);
+  vector<fancy_allocator> values{fancy_allocator(arena)};
+
+  fill(values, 4);
+  const auto *data = values.data();
+  const auto capacity = values.capacity();
+
+  // an allocation after the buffer keeps it from growing in place
+  static_cast<void>(pr::arena_allocator<int>(arena).allocate(1));
+  fill(values, static_cast<int>(capacity) + 1);
+
+  CHECK(values.data() != data);
+  CHECK(memory.contains(values.data()));
+  CHECK(values.size() == 4 + capacity + 1);
+}
+
+void respects_propagation_traits() {
+  region first_memory;
+  region second_memory;
+  pr::arena first_arena(first_memory.bytes);
+  pr::arena second_arena(second_memory.bytes);
+  const fancy_allocator first(first_arena);
+  const fancy_allocator second(second_arena);
+
+  vector<fancy_allocator> source(first);
+  fill(source, 16);
+
+  // unequal allocators that do not propagate: elements move one by one
+  vector<fancy_allocator> moved(second);
+  moved = std::move(source);
+  CHECK(moved.get_allocator() == second);
+  CHECK(second_memory.contains(moved.data()));
+  CHECK(holds_sequence(moved, 16));
+
+  vector<fancy_allocator> copied(first);
+  copied = moved;
+  CHECK(copied.get_allocator() == first);
+  CHECK(first_memory.contains(copied.data()));
+  CHECK(holds_sequence(copied, 16));
+
+  // equal allocators: the storage itself is taken
+  vector<fancy_allocator> stolen(first);
+  const auto *data = copied.data();
+  stolen = std::move(copied);
+  CHECK(stolen.data() == data and copied.empty());
+
+  vector<fancy_allocator> swapped(first);
+  swapped.swap(stolen);
+  CHECK(swapped.data() == data and stolen.empty());
+  CHECK(holds_sequence(swapped, 16));
+}
+
+} // namespace
+
+auto main() -> int {
+  slack_becomes_capacity();
+  grows_in_place();
+  reallocates_when_blocked();
+  respects_propagation_traits();
+  return pr::test::exit_status();
+}